@@ -0,0 +1,86 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Arena Request Benchmark
+ * ============================================================================
+ * 
+ * This benchmark simulates request handlers that make a thousand small
+ * allocations which all die at the end of the request. It compares an
+ * arena reset once per request with a mem_free for every allocation and
+ * reports the time per request.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_REQUESTS      10000
+#define BENCH_PER_REQUEST   1000
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e6
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static size_t request_size(size_t i)
+{
+    return 16 + (i * 37) % 240;
+}
+
+static double run_arena(void)
+{
+    struct timespec start, end;
+    mem_arena_t *arena = mem_arena_create(0);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t r = 0; r < BENCH_REQUESTS; r++) {
+        for (size_t i = 0; i < BENCH_PER_REQUEST; i++) {
+            *(char*)mem_arena_alloc(arena, request_size(i)) = 1;
+        }
+        mem_arena_reset(arena);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    mem_arena_destroy(arena);
+    return elapsed_us(&start, &end) / BENCH_REQUESTS;
+}
+
+static double run_malloc(void)
+{
+    struct timespec start, end;
+    static void *live[BENCH_PER_REQUEST];
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t r = 0; r < BENCH_REQUESTS; r++) {
+        for (size_t i = 0; i < BENCH_PER_REQUEST; i++) {
+            live[i] = mem_malloc(request_size(i));
+            *(char*)live[i] = 1;
+        }
+        for (size_t i = 0; i < BENCH_PER_REQUEST; i++) {
+            mem_free(live[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    return elapsed_us(&start, &end) / BENCH_REQUESTS;
+}
+
+int main(void)
+{
+    if (mem_init(MEM_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("%d ALLOCATIONS PER REQUEST\n", BENCH_PER_REQUEST);
+    printf("========================================\n");
+    printf("mem_arena:   %8.2f us per request\n", run_arena());
+    printf("mem_malloc:  %8.2f us per request\n", run_malloc());
+    printf("========================================\n");
+    
+    mem_cleanup();
+    return 0;
+}
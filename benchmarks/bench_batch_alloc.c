@@ -0,0 +1,74 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Batch Allocation Benchmark
+ * ============================================================================
+ * 
+ * This benchmark models a message decoder: each round allocates a few
+ * hundred objects of one size and frees them all again. It compares
+ * separate mem_malloc/mem_free calls with one mem_malloc_batch and one
+ * mem_free_batch per round, and reports the time per object for the
+ * whole round trip.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_OBJECTS       300
+#define BENCH_ROUNDS        20000
+
+static const size_t bench_sizes[] = {24, 64, 128, 512, 2048};
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9
+         + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static double time_rounds(size_t size, bool batched)
+{
+    void *objects[BENCH_OBJECTS];
+    struct timespec start, end;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+        if (batched) {
+            mem_malloc_batch(size, BENCH_OBJECTS, objects);
+            mem_free_batch(objects, BENCH_OBJECTS);
+            continue;
+        }
+        for (size_t i = 0; i < BENCH_OBJECTS; i++) {
+            objects[i] = mem_malloc(size);
+        }
+        for (size_t i = 0; i < BENCH_OBJECTS; i++) {
+            mem_free(objects[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    return elapsed_ns(&start, &end) / ((double)BENCH_ROUNDS * BENCH_OBJECTS);
+}
+
+int main(void)
+{
+    if (mem_init(MEM_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("%d OBJECTS PER ROUND: SEPARATE VS BATCH\n", BENCH_OBJECTS);
+    printf("========================================\n");
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        double separate = time_rounds(bench_sizes[i], false);
+        double batched = time_rounds(bench_sizes[i], true);
+        printf("%4zu bytes: %6.1f ns separate, %6.1f ns batch (%.1fx)\n",
+               bench_sizes[i], separate, batched, separate / batched);
+    }
+    printf("========================================\n");
+    
+    mem_cleanup();
+    return 0;
+}
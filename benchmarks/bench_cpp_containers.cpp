@@ -0,0 +1,77 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - C++ Container Benchmark
+ * ============================================================================
+ * 
+ * This benchmark churns a std::map and a std::unordered_map with random
+ * inserts and erases over a fixed key range, so node allocations and
+ * frees are interleaved the way long-running services see them. Each
+ * container runs with the default std::allocator (libc malloc), with
+ * memalloc::allocator and with a std::pmr resource over the heaps, and
+ * reports the time per operation.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <random>
+#include <unordered_map>
+
+#define BENCH_OPERATIONS    2000000
+#define BENCH_KEYS          100000
+
+using node_t = std::pair<const int, int>;
+using mem_map_t = std::map<int, int, std::less<int>, memalloc::allocator<node_t>>;
+using mem_hash_t = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                                      memalloc::allocator<node_t>>;
+
+template <typename Map>
+static double churn(Map &map)
+{
+    std::mt19937 rng(42);
+    auto start = std::chrono::steady_clock::now();
+    
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        int key = static_cast<int>(rng() % BENCH_KEYS);
+        if (i % 2 == 0) {
+            map[key] = i;
+        } else {
+            map.erase(key);
+        }
+    }
+    
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / BENCH_OPERATIONS;
+}
+
+template <typename Map>
+static void report(const char *name, Map map)
+{
+    std::printf("%-36s %6.1f ns per operation\n", name, churn(map));
+}
+
+int main()
+{
+    if (mem_init(MEM_HEAP_SIZE) != 0) {
+        std::printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    std::printf("========================================\n");
+    std::printf("2M MAP OPERATIONS OVER 100K KEYS\n");
+    std::printf("========================================\n");
+    report("std::map, std::allocator:", std::map<int, int>());
+    report("std::map, memalloc::allocator:", mem_map_t());
+    report("std::pmr::map, heap_resource:", std::pmr::map<int, int>(memalloc::heap()));
+    report("unordered_map, std::allocator:", std::unordered_map<int, int>());
+    report("unordered_map, memalloc::allocator:", mem_hash_t());
+    report("pmr::unordered_map, heap_resource:", std::pmr::unordered_map<int, int>(memalloc::heap()));
+    std::printf("========================================\n");
+    
+    mem_cleanup();
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Fragmentation Benchmark
+ * ============================================================================
+ * 
+ * This benchmark runs a long-lived heap through a million random
+ * free/allocate steps over a fixed set of slots, with sizes drawn from
+ * a small, a medium and a large range below the mmap threshold. It
+ * reports the time per step, the cost of one mem_get_stats call on the
+ * fragmented heap, and mem_get_stats().fragmentation_ratio, the share of
+ * free heap memory outside the largest free block, at the end of the run.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_SLOTS         20000
+#define BENCH_STEPS         1000000
+#define BENCH_STATS_CALLS   10000
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+static size_t next_random(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (size_t)rng_state;
+}
+
+static size_t random_size(void)
+{
+    size_t kind = next_random() % 100;
+    
+    if (kind < 80) {
+        return 16 + next_random() % 496;
+    }
+    if (kind < 97) {
+        return 1024 + next_random() % (15 * 1024);
+    }
+    return 16 * 1024 + next_random() % (96 * 1024);
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9
+         + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+int main(void)
+{
+    static void *slots[BENCH_SLOTS];
+    struct timespec start, end, stats_start, stats_end;
+    mem_stats_t stats;
+    
+    if (mem_init(MEM_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t step = 0; step < BENCH_STEPS; step++) {
+        size_t slot = next_random() % BENCH_SLOTS;
+        mem_free(slots[slot]);
+        slots[slot] = mem_malloc(random_size());
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    mem_flush_thread_cache();
+    clock_gettime(CLOCK_MONOTONIC, &stats_start);
+    for (size_t call = 0; call < BENCH_STATS_CALLS; call++) {
+        mem_get_stats(&stats);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stats_end);
+    printf("========================================\n");
+    printf("RANDOM FREE/ALLOCATE OVER %d SLOTS\n", BENCH_SLOTS);
+    printf("========================================\n");
+    printf("Time per step:      %8.1f ns\n", elapsed_ns(&start, &end) / BENCH_STEPS);
+    printf("mem_get_stats:      %8.1f ns\n", elapsed_ns(&stats_start, &stats_end) / BENCH_STATS_CALLS);
+    printf("Live bytes:         %8zu KB\n", stats.current_usage / 1024);
+    printf("Free blocks:        %8zu\n", stats.free_blocks);
+    printf("Fragmentation:      %8zu%%\n", stats.fragmentation_ratio);
+    printf("========================================\n");
+    
+    mem_cleanup();
+    return 0;
+}
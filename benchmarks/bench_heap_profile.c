@@ -0,0 +1,73 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Heap Profile Overhead Benchmark
+ * ============================================================================
+ * 
+ * This benchmark runs small malloc/free pairs with the heap profiler off
+ * and with it sampling every MEM_SAMPLE_INTERVAL bytes, and reports the
+ * share of the throughput sampling costs. Blocks that miss the sample
+ * only pay a countdown decrement; the rare sampled one pays a stack
+ * capture and a mapping. The rounds alternate between both settings and
+ * the best round of each is kept.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_HEAP_SIZE     (64 * 1024 * 1024)
+#define BENCH_OPERATIONS    20000000
+#define BENCH_ROUNDS        5
+
+static double elapsed_s(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double measure(size_t sample_interval)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    struct timespec start, end;
+    
+    config.heap_size = BENCH_HEAP_SIZE;
+    config.sample_interval = sample_interval;
+    if (mem_init_config(&config) != 0) {
+        return 0.0;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        void *ptr = mem_malloc(16 + (size_t)(i % 16) * 16);
+        *(volatile char*)ptr = 1;
+        mem_free(ptr);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    mem_cleanup();
+    return BENCH_OPERATIONS / elapsed_s(&start, &end) / 1e6;
+}
+
+int main(void)
+{
+    double sampled = 0.0;
+    double unsampled = 0.0;
+    
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double on = measure(MEM_SAMPLE_INTERVAL);
+        double off = measure(0);
+        sampled = on > sampled ? on : sampled;
+        unsampled = off > unsampled ? off : unsampled;
+    }
+    
+    printf("========================================\n");
+    printf("HEAP PROFILE OVERHEAD, 1 THREAD\n");
+    printf("========================================\n");
+    printf("Profiler off:       %8.1f Mops/s\n", unsampled);
+    printf("Sampling %4d KB:   %8.1f Mops/s\n", MEM_SAMPLE_INTERVAL / 1024, sampled);
+    printf("Overhead:           %8.2f %%\n", 100.0 * (unsampled - sampled) / unsampled);
+    printf("========================================\n");
+    return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Malloc Latency Benchmark
+ * ============================================================================
+ * 
+ * This benchmark measures the latency of a malloc/free pair while an
+ * increasing number of blocks stay live in the heap. With segregated free
+ * lists the cost per operation should stay flat as the live count grows.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_HEAP_SIZE     (256 * 1024 * 1024)
+#define BENCH_OPERATIONS    200000
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9
+         + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void** fill_heap(size_t live_blocks)
+{
+    void **live = malloc(sizeof(void*) * live_blocks);
+    
+    for (size_t i = 0; i < live_blocks; i++) {
+        live[i] = mem_malloc((i % 256) + 1);
+    }
+    return live;
+}
+
+static double measure_pairs(void)
+{
+    struct timespec start, end;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        void *ptr = mem_malloc(64 + (size_t)(i % 8) * 32);
+        mem_free(ptr);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    return elapsed_ns(&start, &end) / BENCH_OPERATIONS;
+}
+
+static void run_case(size_t live_blocks)
+{
+    if (mem_init(BENCH_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return;
+    }
+    
+    void **live = fill_heap(live_blocks);
+    printf("%10zu live blocks: %8.1f ns per malloc/free pair\n",
+           live_blocks, measure_pairs());
+    
+    free(live);
+    mem_cleanup();
+}
+
+int main(void)
+{
+    static const size_t live_counts[] = { 0, 1000, 10000, 100000, 1000000 };
+    
+    printf("========================================\n");
+    printf("MALLOC LATENCY VS. LIVE BLOCK COUNT\n");
+    printf("========================================\n");
+    
+    for (size_t i = 0; i < sizeof(live_counts) / sizeof(live_counts[0]); i++) {
+        run_case(live_counts[i]);
+    }
+    
+    printf("========================================\n");
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Realloc Growth Benchmark
+ * ============================================================================
+ * 
+ * This benchmark grows a buffer the way a log or serialization buffer
+ * grows, in fixed increments up to 256MB, and reports the time per
+ * realloc. Large buffers live in their own mapping and are grown with
+ * mremap, so the cost should not track the buffer size. A second run
+ * appends to a heap-sized buffer in small steps, like a vector push,
+ * and also reports how many reallocs had to move the buffer.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef void* (*realloc_fn)(void*, size_t);
+
+typedef struct growth_plan {
+    size_t start;
+    size_t final;
+    size_t increment;
+} growth_plan_t;
+
+static const growth_plan_t mapped_plan = {256 * 1024, 256 * 1024 * 1024, 1024 * 1024};
+static const growth_plan_t append_plan = {64, 96 * 1024, 64};
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e6
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static double measure_growth(const growth_plan_t *plan, realloc_fn resize,
+                             void (*release)(void*), size_t *moves)
+{
+    struct timespec start, end;
+    size_t steps = 0;
+    char *buffer = resize(NULL, plan->start);
+    
+    *moves = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t size = plan->start; size < plan->final; size += plan->increment) {
+        char *grown = resize(buffer, size + plan->increment);
+        *moves += grown != buffer;
+        buffer = grown;
+        buffer[size] = 1;
+        steps++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    release(buffer);
+    return elapsed_us(&start, &end) / (double)steps;
+}
+
+static void report(const char *name, const growth_plan_t *plan, realloc_fn resize, void (*release)(void*))
+{
+    size_t moves;
+    double per_call = measure_growth(plan, resize, release, &moves);
+    
+    printf("%-12s %8.2f us per realloc, %6zu moves\n", name, per_call, moves);
+}
+
+int main(void)
+{
+    if (mem_init(MEM_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("REALLOC GROWTH TO 256MB IN 1MB STEPS\n");
+    printf("========================================\n");
+    report("mem_realloc:", &mapped_plan, mem_realloc, mem_free);
+    report("realloc:", &mapped_plan, realloc, free);
+    printf("========================================\n");
+    printf("VECTOR APPEND TO 96KB IN 64B STEPS\n");
+    printf("========================================\n");
+    report("mem_realloc:", &append_plan, mem_realloc, mem_free);
+    report("realloc:", &append_plan, realloc, free);
+    printf("========================================\n");
+    
+    mem_cleanup();
+    return 0;
+}
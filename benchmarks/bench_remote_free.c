@@ -0,0 +1,140 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Producer/Consumer Benchmark
+ * ============================================================================
+ * 
+ * One producer thread allocates messages and hands them to 1 to 8
+ * consumer threads through single-producer rings; the consumers free
+ * them. Every free is therefore a cross-thread free. With remote free
+ * stacks the consumers never take the producer's heap lock, so the
+ * aggregate free throughput should hold steady as consumers are added.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_HEAP_SIZE     (64 * 1024 * 1024)
+#define BENCH_MESSAGES      2000000
+#define BENCH_MAX_CONSUMERS 8
+#define RING_SIZE           1024
+
+typedef struct {
+    void *slots[RING_SIZE];
+    size_t head;
+    size_t tail;
+    size_t expected;
+    double free_ns;
+} bench_ring_t;
+
+typedef struct {
+    bench_ring_t *rings;
+    int consumers;
+} bench_producer_t;
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9
+         + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void ring_push(bench_ring_t *ring, void *msg)
+{
+    size_t tail = ring->tail;
+    
+    while (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == RING_SIZE) {
+        sched_yield();
+    }
+    ring->slots[tail % RING_SIZE] = msg;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static void* ring_pop(bench_ring_t *ring)
+{
+    size_t head = ring->head;
+    
+    while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == head) {
+        sched_yield();
+    }
+    void *msg = ring->slots[head % RING_SIZE];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return msg;
+}
+
+static void* producer(void *arg)
+{
+    bench_producer_t *work = arg;
+    
+    for (size_t i = 0; i < BENCH_MESSAGES; i++) {
+        char *msg = mem_malloc(32 + (i % 8) * 32);
+        msg[0] = (char)i;
+        ring_push(&work->rings[i % (size_t)work->consumers], msg);
+    }
+    return NULL;
+}
+
+static void* consumer(void *arg)
+{
+    bench_ring_t *ring = arg;
+    struct timespec start, end;
+    double total = 0.0;
+    
+    for (size_t i = 0; i < ring->expected; i++) {
+        void *msg = ring_pop(ring);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        mem_free(msg);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsed_ns(&start, &end);
+    }
+    ring->free_ns = total;
+    return NULL;
+}
+
+static void run_case(int consumers)
+{
+    static bench_ring_t rings[BENCH_MAX_CONSUMERS];
+    bench_producer_t work = { rings, consumers };
+    pthread_t threads[BENCH_MAX_CONSUMERS + 1];
+    double free_ns = 0.0;
+    
+    for (int i = 0; i < consumers; i++) {
+        rings[i] = (bench_ring_t){ .expected = BENCH_MESSAGES / (size_t)consumers };
+        pthread_create(&threads[i + 1], NULL, consumer, &rings[i]);
+    }
+    pthread_create(&threads[0], NULL, producer, &work);
+    for (int i = 0; i <= consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    for (int i = 0; i < consumers; i++) {
+        free_ns += rings[i].free_ns;
+    }
+    printf("%10d %14.1f %18.1f\n", consumers,
+           free_ns / BENCH_MESSAGES, BENCH_MESSAGES / (free_ns / consumers) * 1e3);
+}
+
+int main(void)
+{
+    if (mem_init(BENCH_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("CROSS-THREAD FREE VS. CONSUMER COUNT\n");
+    printf("========================================\n");
+    printf("%10s %14s %18s\n", "consumers", "ns per free", "frees (Mops/s)");
+    
+    for (int consumers = 1; consumers <= BENCH_MAX_CONSUMERS; consumers *= 2) {
+        run_case(consumers);
+    }
+    
+    printf("========================================\n");
+    mem_cleanup();
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Sized Free Benchmark
+ * ============================================================================
+ * 
+ * This benchmark allocates batches of objects of one size and frees them
+ * again, once with mem_free and once with mem_free_sized, and reports
+ * the time per free. The batches stay within the thread's magazines and
+ * caches, so the numbers isolate the cost of finding the size class.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_BATCH         16
+#define BENCH_ROUNDS        200000
+
+static const size_t bench_sizes[] = {16, 48, 64, 200, 480};
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9
+         + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* Nanoseconds per free, allocation time excluded */
+static double time_frees(size_t size, bool sized)
+{
+    void *objects[BENCH_BATCH];
+    struct timespec start, end;
+    double total = 0;
+    
+    for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_BATCH; i++) {
+            objects[i] = mem_malloc(size);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < BENCH_BATCH; i++) {
+            if (sized) {
+                mem_free_sized(objects[i], size);
+            } else {
+                mem_free(objects[i]);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsed_ns(&start, &end);
+    }
+    return total / (BENCH_ROUNDS * BENCH_BATCH);
+}
+
+int main(void)
+{
+    if (mem_init(MEM_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("FREE VS SIZED FREE\n");
+    printf("========================================\n");
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        double plain = time_frees(bench_sizes[i], false);
+        double sized = time_frees(bench_sizes[i], true);
+        printf("%3zu bytes: %5.1f ns mem_free, %5.1f ns mem_free_sized\n", bench_sizes[i], plain, sized);
+    }
+    printf("========================================\n");
+    
+    mem_cleanup();
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Statistics Overhead Benchmark
+ * ============================================================================
+ * 
+ * This benchmark runs small malloc/free pairs on 16 threads, once with
+ * the statistics counters enabled and once with disable_stats set, and
+ * reports the share of the throughput the counters cost. The rounds
+ * alternate between both settings and the best round of each is kept,
+ * so background noise does not land on one side only.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_HEAP_SIZE     (64 * 1024 * 1024)
+#define BENCH_OPERATIONS    1000000
+#define BENCH_THREADS       16
+#define BENCH_ROUNDS        5
+
+static double elapsed_s(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void* pair_worker(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        void *ptr = mem_malloc(16 + (size_t)(i % 16) * 16);
+        *(volatile char*)ptr = 1;
+        mem_free(ptr);
+    }
+    return NULL;
+}
+
+static double measure(bool disable_stats)
+{
+    pthread_t workers[BENCH_THREADS];
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    struct timespec start, end;
+    
+    config.heap_size = BENCH_HEAP_SIZE;
+    config.disable_stats = disable_stats;
+    if (mem_init_config(&config) != 0) {
+        return 0.0;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_THREADS; i++) {
+        pthread_create(&workers[i], NULL, pair_worker, NULL);
+    }
+    for (int i = 0; i < BENCH_THREADS; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    mem_cleanup();
+    return (double)BENCH_THREADS * BENCH_OPERATIONS / elapsed_s(&start, &end) / 1e6;
+}
+
+int main(void)
+{
+    double with_stats = 0.0;
+    double without_stats = 0.0;
+    
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double on = measure(false);
+        double off = measure(true);
+        with_stats = on > with_stats ? on : with_stats;
+        without_stats = off > without_stats ? off : without_stats;
+    }
+    
+    printf("========================================\n");
+    printf("STATISTICS OVERHEAD, %d THREADS\n", BENCH_THREADS);
+    printf("========================================\n");
+    printf("Stats enabled:      %8.1f Mops/s\n", with_stats);
+    printf("Stats disabled:     %8.1f Mops/s\n", without_stats);
+    printf("Overhead:           %8.2f %%\n", 100.0 * (without_stats - with_stats) / without_stats);
+    printf("========================================\n");
+    return 0;
+}
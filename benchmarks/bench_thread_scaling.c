@@ -0,0 +1,101 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Thread Scaling Benchmark
+ * ============================================================================
+ * 
+ * This benchmark runs small malloc/free pairs from 1 to 16 threads and
+ * reports the aggregate throughput of the custom allocator, with per-thread
+ * and with per-CPU caches, next to the system malloc. Either cache keeps
+ * the pairs off the heap locks, so throughput should grow with the number
+ * of cores.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_HEAP_SIZE     (64 * 1024 * 1024)
+#define BENCH_OPERATIONS    1000000
+#define BENCH_MAX_THREADS   16
+
+typedef void* (*alloc_fn)(size_t);
+typedef void (*free_fn)(void*);
+
+typedef struct {
+    alloc_fn alloc;
+    free_fn release;
+} bench_allocator_t;
+
+static double elapsed_s(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void* pair_worker(void *arg)
+{
+    const bench_allocator_t *allocator = arg;
+    
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        void *ptr = allocator->alloc(16 + (size_t)(i % 16) * 16);
+        *(volatile char*)ptr = 1;
+        allocator->release(ptr);
+    }
+    return NULL;
+}
+
+static double measure_threads(const bench_allocator_t *allocator, int threads)
+{
+    pthread_t workers[BENCH_MAX_THREADS];
+    struct timespec start, end;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, pair_worker, (void*)allocator);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    return (double)threads * BENCH_OPERATIONS / elapsed_s(&start, &end) / 1e6;
+}
+
+static double measure_custom(mem_cache_mode_t mode, int threads)
+{
+    static const bench_allocator_t custom = { mem_malloc, mem_free };
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    double mops = 0.0;
+    
+    config.heap_size = BENCH_HEAP_SIZE;
+    config.cache_mode = mode;
+    if (mem_init_config(&config) == 0) {
+        mops = mem_get_cache_mode() == mode ? measure_threads(&custom, threads) : 0.0;
+        mem_cleanup();
+    }
+    return mops;
+}
+
+int main(void)
+{
+    static const bench_allocator_t system = { malloc, free };
+    
+    printf("========================================\n");
+    printf("MALLOC/FREE THROUGHPUT VS. THREAD COUNT\n");
+    printf("========================================\n");
+    printf("%8s %14s %14s %14s\n", "threads", "thread Mops/s", "cpu Mops/s", "libc Mops/s");
+    
+    for (int threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+        printf("%8d %14.1f %14.1f %14.1f\n", threads,
+               measure_custom(MEM_CACHE_PER_THREAD, threads),
+               measure_custom(MEM_CACHE_PER_CPU, threads),
+               measure_threads(&system, threads));
+    }
+    
+    printf("========================================\n");
+    return 0;
+}
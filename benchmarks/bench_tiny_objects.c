@@ -0,0 +1,95 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Tiny Object Benchmark
+ * ============================================================================
+ * 
+ * This benchmark allocates a million objects of each tiny size through
+ * mem_malloc, frees them again, and reports the time per operation and
+ * the memory each object occupies, counted as the distinct pages the
+ * objects land on. Tiny objects carry no block header, so their cost
+ * should be the rounded-up size plus a share of the run header, where a
+ * heap block would add an 8-byte header and a 24-byte minimum payload.
+ * 
+ * ============================================================================
+ */
+
+#include "../include/mem_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_OBJECTS       1000000
+#define BENCH_PAGE          4096
+
+static const size_t bench_sizes[] = {8, 16, 24, 32, 48, 64};
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9
+         + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static size_t count_pages(void **objects)
+{
+    uintptr_t low = UINTPTR_MAX, high = 0;
+    size_t pages = 0;
+    
+    for (size_t i = 0; i < BENCH_OBJECTS; i++) {
+        uintptr_t page = (uintptr_t)objects[i] / BENCH_PAGE;
+        low = page < low ? page : low;
+        high = page > high ? page : high;
+    }
+    
+    unsigned char *seen = calloc(high - low + 1, 1);
+    for (size_t i = 0; seen != NULL && i < BENCH_OBJECTS; i++) {
+        uintptr_t page = (uintptr_t)objects[i] / BENCH_PAGE - low;
+        pages += seen[page] ? 0 : 1;
+        seen[page] = 1;
+    }
+    free(seen);
+    return pages;
+}
+
+static void run_size(void **objects, size_t size)
+{
+    struct timespec start, mid, end;
+    size_t block = (size + 8 + 7) & ~(size_t)7;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < BENCH_OBJECTS; i++) {
+        objects[i] = mem_malloc(size);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &mid);
+    size_t pages = count_pages(objects);
+    for (size_t i = 0; i < BENCH_OBJECTS; i++) {
+        mem_free(objects[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    printf("%2zu bytes: %5.1f ns alloc, %5.1f ns free, %5.1f bytes per object (heap block: %zu)\n",
+           size, elapsed_ns(&start, &mid) / BENCH_OBJECTS, elapsed_ns(&mid, &end) / BENCH_OBJECTS,
+           (double)pages * BENCH_PAGE / BENCH_OBJECTS, block < 32 ? 32 : block);
+}
+
+int main(void)
+{
+    void **objects = malloc(sizeof(void*) * BENCH_OBJECTS);
+    
+    if (objects == NULL || mem_init(MEM_HEAP_SIZE) != 0) {
+        printf("Failed to initialize memory allocator\n");
+        return 1;
+    }
+    
+    printf("========================================\n");
+    printf("1M TINY OBJECTS PER SIZE\n");
+    printf("========================================\n");
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        run_size(objects, bench_sizes[i]);
+    }
+    printf("========================================\n");
+    
+    mem_cleanup();
+    free(objects);
+    return 0;
+}
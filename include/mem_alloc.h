@@ -24,46 +24,128 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* ========================================================================== */
 /* CONSTANTS AND CONFIGURATION */
 /* ========================================================================== */
 
+/* Default alignment; build with -DMEM_ALIGNMENT=16 for long double/SSE */
+#ifndef MEM_ALIGNMENT
 #define MEM_ALIGNMENT           8
-#define MEM_MIN_BLOCK_SIZE      16
-#define MEM_HEAP_SIZE           (1024 * 1024)  /* 1MB default heap */
+#endif
+#if MEM_ALIGNMENT < 8 || (MEM_ALIGNMENT & (MEM_ALIGNMENT - 1)) != 0
+#error "MEM_ALIGNMENT must be a power of two of at least 8"
+#endif
+#define MEM_MIN_BLOCK_SIZE      24             /* free links + size footer */
+#define MEM_HEAP_SIZE           (1024 * 1024)  /* 1MB initially committed */
+#define MEM_HEAP_RESERVE        ((size_t)1 << 30)  /* 1GB address space per heap */
+#define MEM_MMAP_THRESHOLD      (128 * 1024)   /* larger requests get their own mapping */
+#define MEM_DECAY_MS            10000          /* free pages are purged after 10s */
+#define MEM_ARENA_CHUNK_SIZE    (64 * 1024)    /* default arena chunk capacity */
 #define MEM_MAX_BLOCKS          1024
-#define MEM_MAGIC_ALLOCATED     0xDEADBEEF
-#define MEM_MAGIC_FREE          0xFEEDFACE
+#define MEM_STATS_CLASSES       16             /* power-of-two size classes, from 8 bytes */
+#define MEM_SAMPLE_INTERVAL     (2 * 1024 * 1024)  /* suggested heap profile sampling rate */
 
 /* ========================================================================== */
 /* DATA STRUCTURES */
 /* ========================================================================== */
 
+/* Payload size with MEM_BLOCK_* flags packed into the low three bits */
 typedef struct mem_block {
-    size_t size;
-    bool is_free;
-    uint32_t magic;
-    struct mem_block *next;
-    struct mem_block *prev;
+    size_t header;
 } mem_block_t;
 
 typedef struct mem_stats {
     size_t total_allocated;
     size_t total_freed;
     size_t current_usage;
-    size_t peak_usage;
+    size_t peak_usage;          /* approximate, see mem_get_stats() */
     size_t num_allocations;
     size_t num_frees;
     size_t num_blocks;
-    size_t fragmentation_ratio;
+    size_t fragmentation_ratio; /* percent of free heap bytes outside the largest free block */
+    size_t purged_bytes;        /* returned to the OS with madvise, cumulative */
+    size_t retained_bytes;      /* free but still backed by memory */
+    size_t free_bytes;          /* free heap bytes */
+    size_t free_blocks;
+    size_t largest_free;        /* largest free heap block */
 } mem_stats_t;
 
+/*
+ * Class i counts sizes in [2^(i+3), 2^(i+4)); the last class also holds
+ * everything larger. Requests are counted by the size actually served.
+ */
+typedef struct mem_size_histogram {
+    size_t requests[MEM_STATS_CLASSES];
+    size_t free_blocks[MEM_STATS_CLASSES];
+} mem_size_histogram_t;
+
+/* Where freed small blocks wait before going back to their heap */
+typedef enum mem_cache_mode {
+    MEM_CACHE_PER_THREAD = 0,
+    MEM_CACHE_PER_CPU        /* rseq-based; falls back to per-thread */
+} mem_cache_mode_t;
+
+/*
+ * Each heap commits heap_size up front and grows up to heap_reserve.
+ * Requests of at least mmap_threshold bytes bypass the heaps. Free pages
+ * are returned to the OS once they stayed free for decay_ms (negative
+ * disables purging), either from the free path or from a background
+ * thread when background_purge is set. disable_stats stops counting
+ * allocations; mem_get_stats then only reports the state of the heaps.
+ * A non-zero sample_interval turns on the heap profiler, which samples
+ * one allocation every sample_interval bytes on average.
+ */
+typedef struct mem_config {
+    size_t heap_size;
+    size_t heap_reserve;
+    size_t mmap_threshold;
+    mem_cache_mode_t cache_mode;
+    long decay_ms;
+    bool background_purge;
+    bool disable_stats;
+    size_t sample_interval;
+} mem_config_t;
+
+#define MEM_CONFIG_DEFAULT { MEM_HEAP_SIZE, MEM_HEAP_RESERVE, MEM_MMAP_THRESHOLD, \
+                             MEM_CACHE_PER_THREAD, MEM_DECAY_MS, false, false, 0 }
+
+/* Fixed-size object pool; see mem_pool_create() */
+typedef struct mem_pool mem_pool_t;
+
+typedef struct mem_pool_stats {
+    size_t object_size;         /* size rounded up to the object stride */
+    size_t objects_in_use;
+    size_t objects_free;        /* free slots in the pool's slabs */
+    size_t slab_count;
+    size_t slab_bytes;
+} mem_pool_stats_t;
+
+/* Region allocator; see mem_arena_create() */
+typedef struct mem_arena mem_arena_t;
+
+/* Arena position returned by mem_arena_save() */
+typedef struct mem_arena_marker {
+    void *chunk;
+    size_t used;
+} mem_arena_marker_t;
+
+typedef struct mem_arena_stats {
+    size_t chunk_count;
+    size_t chunk_bytes;         /* capacity of all chunks */
+    size_t used_bytes;          /* handed out since the last reset */
+} mem_arena_stats_t;
+
+/* Live block recorded by MALLOC in DEBUG builds */
 typedef struct mem_leak {
     void *ptr;
     size_t size;
     const char *file;
     int line;
-    struct mem_leak *next;
+    uint64_t timestamp_ns;      /* CLOCK_MONOTONIC_COARSE at allocation */
 } mem_leak_t;
 
 /* ========================================================================== */
@@ -73,28 +155,77 @@ typedef struct mem_leak {
 void* mem_malloc(size_t size);
 void mem_free(void *ptr);
 void* mem_realloc(void *ptr, size_t new_size);
+
+/*
+ * Sized forms: size is anything from the size requested for ptr up to
+ * mem_get_block_size(ptr). It is trusted instead of validating the
+ * pointer, so a wrong size is only caught by DEBUG builds; 0 means unknown.
+ */
+void mem_free_sized(void *ptr, size_t size);
+void* mem_realloc_sized(void *ptr, size_t old_size, size_t new_size);
+
+/* Returns how many of the count blocks it stored; mem_free_batch reorders ptrs */
+size_t mem_malloc_batch(size_t size, size_t count, void **ptrs);
+void mem_free_batch(void **ptrs, size_t count);
+
 void* mem_calloc(size_t nmemb, size_t size);
+void* mem_aligned_alloc(size_t alignment, size_t size);
+void* mem_memalign(size_t alignment, size_t size);
+int mem_posix_memalign(void **memptr, size_t alignment, size_t size);
+
+/* ========================================================================== */
+/* OBJECT POOLS */
+/* ========================================================================== */
+
+mem_pool_t* mem_pool_create(size_t object_size, size_t alignment);
+void mem_pool_destroy(mem_pool_t *pool);
+void* mem_pool_alloc(mem_pool_t *pool);
+void mem_pool_free(mem_pool_t *pool, void *ptr);
+void mem_pool_get_stats(mem_pool_t *pool, mem_pool_stats_t *stats);
+
+/* ========================================================================== */
+/* ARENAS */
+/* ========================================================================== */
+
+mem_arena_t* mem_arena_create(size_t chunk_size);
+void mem_arena_destroy(mem_arena_t *arena);
+void* mem_arena_alloc(mem_arena_t *arena, size_t size);
+mem_arena_marker_t mem_arena_save(mem_arena_t *arena);
+void mem_arena_restore(mem_arena_t *arena, mem_arena_marker_t marker);
+void mem_arena_reset(mem_arena_t *arena);
+void mem_arena_get_stats(mem_arena_t *arena, mem_arena_stats_t *stats);
 
 /* ========================================================================== */
 /* MEMORY MANAGEMENT */
 /* ========================================================================== */
 
 int mem_init(size_t heap_size);
+int mem_init_config(const mem_config_t *config);
+mem_cache_mode_t mem_get_cache_mode(void);
 void mem_cleanup(void);
 void mem_defragment(void);
+void mem_purge(void);
 size_t mem_get_block_size(void *ptr);
+void mem_flush_thread_cache(void);
 
 /* ========================================================================== */
 /* DEBUGGING AND STATISTICS */
 /* ========================================================================== */
 
 void mem_get_stats(mem_stats_t *stats);
+void mem_get_size_histogram(mem_size_histogram_t *histogram);
 void mem_print_stats(void);
 void mem_print_heap(void);
 bool mem_check_integrity(void);
 void mem_detect_leaks(void);
 void mem_print_leaks(void);
 
+/* Copies up to max recorded blocks and returns how many are recorded */
+size_t mem_get_leaks(mem_leak_t *leaks, size_t max);
+
+/* Writes the sampled heap as a gperftools heap profile that pprof reads */
+int mem_heap_profile_dump(int fd);
+
 /* ========================================================================== */
 /* DEBUG MACROS */
 /* ========================================================================== */
@@ -112,4 +243,8 @@ void _mem_free_debug(void *ptr, const char *file, int line);
 #define FREE(ptr) mem_free(ptr)
 #endif
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* MEM_ALLOC_H */
@@ -0,0 +1,172 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - C++ Interface
+ * ============================================================================
+ * 
+ * This header adapts the allocator to C++17. memalloc::allocator<T> is a
+ * stateless replacement for std::allocator<T> in standard containers.
+ * memalloc::heap_resource and memalloc::arena_resource implement
+ * std::pmr::memory_resource on top of the heaps and of an arena; the
+ * arena resource ignores deallocation and frees everything on release().
+ * Global operator new and delete are replaced separately, by linking
+ * the C++ library built with `make cpp`.
+ * 
+ * ============================================================================
+ */
+
+#ifndef MEM_ALLOC_HPP
+#define MEM_ALLOC_HPP
+
+#include "mem_alloc.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace memalloc {
+
+/* size bytes aligned to alignment, or nullptr */
+inline void* allocate_bytes(std::size_t size, std::size_t alignment) noexcept
+{
+    return alignment <= MEM_ALIGNMENT ? mem_malloc(size) : mem_aligned_alloc(alignment, size);
+}
+
+/* ========================================================================== */
+/* STANDARD ALLOCATOR */
+/* ========================================================================== */
+
+template <typename T>
+class allocator {
+public:
+    using value_type = T;
+    
+    allocator() noexcept = default;
+    
+    template <typename U>
+    allocator(const allocator<U>&) noexcept
+    {
+    }
+    
+    T* allocate(std::size_t count)
+    {
+        if (count > SIZE_MAX / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        void *ptr = allocate_bytes(count * sizeof(T), alignof(T));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+    
+    void deallocate(T *ptr, std::size_t count) noexcept
+    {
+        mem_free_sized(ptr, count * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const allocator<T>&, const allocator<U>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const allocator<T>&, const allocator<U>&) noexcept
+{
+    return false;
+}
+
+/* ========================================================================== */
+/* MEMORY RESOURCES */
+/* ========================================================================== */
+
+class heap_resource : public std::pmr::memory_resource {
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void *ptr = allocate_bytes(bytes != 0 ? bytes : 1, alignment);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+    
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t) override
+    {
+        mem_free_sized(ptr, bytes != 0 ? bytes : 1);
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return dynamic_cast<const heap_resource*>(&other) != nullptr;
+    }
+};
+
+/* Process-wide heap resource */
+inline heap_resource* heap() noexcept
+{
+    static heap_resource resource;
+    return &resource;
+}
+
+class arena_resource : public std::pmr::memory_resource {
+public:
+    explicit arena_resource(std::size_t chunk_size = 0)
+        : arena_(mem_arena_create(chunk_size))
+    {
+        if (arena_ == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    
+    ~arena_resource() override
+    {
+        mem_arena_destroy(arena_);
+    }
+    
+    arena_resource(const arena_resource&) = delete;
+    arena_resource& operator=(const arena_resource&) = delete;
+    
+    /* Frees everything allocated from the resource at once */
+    void release() noexcept
+    {
+        mem_arena_reset(arena_);
+    }
+    
+    mem_arena_t* arena() const noexcept
+    {
+        return arena_;
+    }
+    
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::size_t slack = alignment > MEM_ALIGNMENT ? alignment - MEM_ALIGNMENT : 0;
+        if (bytes > SIZE_MAX - slack) {
+            throw std::bad_alloc();
+        }
+        void *ptr = mem_arena_alloc(arena_, (bytes != 0 ? bytes : 1) + slack);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+        return reinterpret_cast<void*>((address + slack) & ~static_cast<std::uintptr_t>(alignment - 1));
+    }
+    
+    void do_deallocate(void*, std::size_t, std::size_t) override
+    {
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+    
+private:
+    mem_arena_t *arena_;
+};
+
+} /* namespace memalloc */
+
+#endif /* MEM_ALLOC_HPP */
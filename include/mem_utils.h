@@ -19,27 +19,561 @@
 #define MEM_UTILS_H
 
 #include "mem_alloc.h"
+#include <pthread.h>
+
+/* ========================================================================== */
+/* BLOCK LAYOUT */
+/* ========================================================================== */
+
+/*
+ * Implicit block list: [header][payload ... (footer if free)][header]...
+ * The payload size of every block keeps header + payload a multiple of
+ * MEM_ALIGNMENT. Free blocks repeat their size in a footer so the next
+ * block can find them, and a zero-sized allocated epilogue header closes
+ * the heap. Blocks outside every heap live in their own mapping and are
+ * flagged MEM_BLOCK_MMAPPED. The same bit marks free heap blocks as
+ * MEM_BLOCK_CLEAN (see PAGE PURGING); the two never meet.
+ */
+#define MEM_HEADER_SIZE         sizeof(mem_block_t)
+#define MEM_FOOTER_SIZE         sizeof(size_t)
+#define MEM_HEAP_PADDING        ((MEM_ALIGNMENT - MEM_HEADER_SIZE % MEM_ALIGNMENT) % MEM_ALIGNMENT)
+
+#define MEM_BLOCK_FREE          ((size_t)0x1)
+#define MEM_BLOCK_PREV_FREE     ((size_t)0x2)
+#define MEM_BLOCK_MMAPPED       ((size_t)0x4)
+#define MEM_BLOCK_CLEAN         ((size_t)0x4)
+#define MEM_BLOCK_FLAGS         ((size_t)0x7)
+
+static inline size_t mem_block_size(const mem_block_t *block)
+{
+    return block->header & ~MEM_BLOCK_FLAGS;
+}
+
+static inline bool mem_block_is_free(const mem_block_t *block)
+{
+    return (block->header & MEM_BLOCK_FREE) != 0;
+}
+
+static inline bool mem_block_is_prev_free(const mem_block_t *block)
+{
+    return (block->header & MEM_BLOCK_PREV_FREE) != 0;
+}
+
+static inline void mem_block_set_size(mem_block_t *block, size_t size)
+{
+    block->header = size | (block->header & MEM_BLOCK_FLAGS);
+}
+
+static inline size_t* mem_block_footer(mem_block_t *block)
+{
+    return (size_t*)((char*)block + MEM_HEADER_SIZE + mem_block_size(block) - MEM_FOOTER_SIZE);
+}
+
+/* Adjacent header, which may be the epilogue */
+static inline mem_block_t* mem_block_successor(mem_block_t *block)
+{
+    return (mem_block_t*)((char*)block + MEM_HEADER_SIZE + mem_block_size(block));
+}
+
+/* ========================================================================== */
+/* SEGREGATED FREE LISTS */
+/* ========================================================================== */
+
+/*
+ * Small free blocks sit in one exact bin per alignment step, with a
+ * bitmap of non-empty bins. Blocks of at least MEM_SMALL_BIN_LIMIT are
+ * indexed by a (size, address) ordered treap for best-fit lookups.
+ */
+#define MEM_SMALL_BIN_COUNT     64
+#define MEM_NUM_BINS            MEM_SMALL_BIN_COUNT
+#define MEM_BITMAP_WORDS        ((MEM_NUM_BINS + 63) / 64)
+#define MEM_SMALL_BIN_LIMIT     (MEM_MIN_BLOCK_SIZE + MEM_SMALL_BIN_COUNT * MEM_ALIGNMENT)
+
+/* Free list links, stored in the payload of free blocks only */
+typedef struct mem_free_node {
+    mem_block_t *next_free;
+    mem_block_t *prev_free;
+} mem_free_node_t;
+
+/* Size tree links, in the same two words as the free list links */
+typedef struct mem_tree_node {
+    mem_block_t *left;
+    mem_block_t *right;
+} mem_tree_node_t;
+
+/* ========================================================================== */
+/* PAGE MAP */
+/* ========================================================================== */
+
+/*
+ * Two-level radix map from 4 KB page number to the owner of the page:
+ * a heap, a tiny run or a large mapping. The kind sits in the low bits
+ * of each entry and the owner pointer in the rest. Leaves cover 1 GB of
+ * address space each and are mapped on first use; pages nobody
+ * registered read as MEM_PAGE_NONE, so lookups never touch user memory.
+ * Heaps register committed pages, tiny runs their own page and large
+ * mappings the page holding their header.
+ */
+#define MEM_PAGE_SHIFT          12
+#define MEM_PAGE_MAP_BITS       35             /* 47-bit user address space */
+#define MEM_PAGE_MAP_LEAF_BITS  18
+#define MEM_PAGE_MAP_ROOT_SIZE  ((size_t)1 << (MEM_PAGE_MAP_BITS - MEM_PAGE_MAP_LEAF_BITS))
+#define MEM_PAGE_KIND_MASK      ((uintptr_t)0x3)
+
+typedef enum {
+    MEM_PAGE_NONE = 0,
+    MEM_PAGE_HEAP = 1,
+    MEM_PAGE_TINY = 2,
+    MEM_PAGE_MMAP = 3
+} mem_page_kind_t;
+
+int mem_page_map_set(void *start, size_t length, mem_page_kind_t kind, void *owner);
+void mem_page_map_clear(void *start, size_t length);
+mem_page_kind_t mem_page_map_lookup(const void *ptr, void **owner);
+
+/* ========================================================================== */
+/* HEAPS */
+/* ========================================================================== */
+
+/*
+ * Each heap is an independent mmap region with its own free bins,
+ * statistics and lock. The region reserves [start, limit) and only
+ * [start, end) is committed; the heap grows by committing more pages
+ * behind the epilogue when no bin can serve a request. Threads are
+ * spread over the heaps round-robin; a block always goes back to the
+ * heap the page map names for it. Blocks freed by threads bound to
+ * another heap are pushed on the lock-free remote_frees stack and merged
+ * back by the next allocation that takes the lock.
+ */
+#define MEM_MAX_HEAPS           8
+#define MEM_HEAPS_PER_CPU       4
+
+typedef struct mem_heap {
+    pthread_mutex_t lock;
+    void *start;
+    void *end;
+    void *limit;
+    mem_block_t *first_block;
+    size_t num_blocks;
+    mem_block_t *free_bins[MEM_NUM_BINS];
+    uint64_t bin_bitmap[MEM_BITMAP_WORDS];
+    mem_block_t *large_tree;
+    size_t free_bytes;          /* kept by the bins, see mem_bin_insert */
+    size_t free_blocks;
+    size_t dirty_bytes;         /* free bytes not flagged MEM_BLOCK_CLEAN */
+    size_t free_histogram[MEM_STATS_CLASSES];
+    struct mem_tcache_entry *remote_frees;
+    uint64_t next_purge;
+    size_t index;
+    int ready;
+} mem_heap_t;
+
+#define MEM_HEAP_GROWTH         (1024 * 1024)  /* minimum commit per growth */
+
+int mem_heap_init(mem_heap_t *heap, size_t heap_size, size_t reserve);
+void mem_heap_destroy(mem_heap_t *heap);
+int mem_heap_grow(mem_heap_t *heap, size_t size);
+mem_heap_t* mem_heap_get(size_t index);
+mem_heap_t* mem_heap_of(void *ptr);
+mem_heap_t* mem_thread_heap(void);
+void mem_for_each_heap(void (*visit)(mem_heap_t *heap, void *arg), void *arg);
+
+/* ========================================================================== */
+/* THREAD CACHES */
+/* ========================================================================== */
+
+/*
+ * Per-thread LIFO lists of recently freed small blocks, one per exact
+ * small bin size. Cached blocks still look allocated to their heap; the
+ * process-wide key stored next to the link marks them as cached.
+ */
+#define MEM_TCACHE_CLASSES      MEM_SMALL_BIN_COUNT
+#define MEM_TCACHE_CAPACITY     32
+#define MEM_TCACHE_BATCH        16
+
+typedef struct mem_tcache_entry {
+    struct mem_tcache_entry *next;
+    uintptr_t key;
+} mem_tcache_entry_t;
+
+void* mem_tcache_alloc(size_t size);
+bool mem_tcache_free(mem_block_t *block, size_t size);
+bool mem_tcache_is_cached(mem_block_t *block);
+void mem_tcache_release_list(mem_tcache_entry_t *entry);
+
+/* ========================================================================== */
+/* PER-CPU CACHES */
+/* ========================================================================== */
+
+/*
+ * Optional replacement for the thread caches: one array stack per CPU
+ * and small size class, updated inside rseq critical sections. Entries
+ * use the thread cache layout and key.
+ */
+#define MEM_PERCPU_CAPACITY     32
+#define MEM_PERCPU_MAX_CPUS     1024
+
+int mem_percpu_init(void);
+void mem_percpu_destroy(void);
+void* mem_percpu_alloc(size_t size);
+bool mem_percpu_free(mem_block_t *block, size_t size);
+void mem_percpu_flush(void);
+
+/* ========================================================================== */
+/* TINY OBJECTS */
+/* ========================================================================== */
+
+/*
+ * Requests of at most MEM_TINY_MAX bytes are served from runs of
+ * MEM_TINY_RUN_SIZE bytes carved from one reserved region. A run holds
+ * objects of a single class after its header; set bits in the bitmap
+ * mark free slots, so objects carry no header. Threads keep small
+ * magazines of tiny objects and move them to and from the runs in
+ * batches under the class lock. Unused runs have class MEM_TINY_CLASSES.
+ */
+#define MEM_TINY_MAX            64
+#define MEM_TINY_CLASSES        (MEM_TINY_MAX / MEM_ALIGNMENT)
+#define MEM_TINY_RUN_SIZE       4096
+#define MEM_TINY_BITMAP_WORDS   (MEM_TINY_RUN_SIZE / MEM_ALIGNMENT / 64)
+#define MEM_TINY_RESERVE        ((size_t)1 << 30)
+#define MEM_TINY_COMMIT         (64 * 1024)    /* region commit step */
+#define MEM_TINY_MAGAZINE       32
+#define MEM_TINY_BATCH          16
+
+typedef struct mem_tiny_run {
+    struct mem_tiny_run *next;
+    struct mem_tiny_run *prev;
+    size_t class_index;
+    size_t free_count;
+    uint64_t bitmap[MEM_TINY_BITMAP_WORDS];
+} mem_tiny_run_t;
+
+#define MEM_TINY_HEADER_SIZE    ((sizeof(mem_tiny_run_t) + MEM_ALIGNMENT - 1) & ~(size_t)(MEM_ALIGNMENT - 1))
+
+int mem_tiny_init(void);
+void mem_tiny_destroy(void);
+bool mem_tiny_owns(void *ptr);
+void* mem_tiny_alloc(size_t size);
+size_t mem_tiny_alloc_batch(size_t size, void **objects, size_t count);
+void mem_tiny_free(void *ptr);
+size_t mem_tiny_free_batch(void **objects, size_t count, size_t *bytes);
+bool mem_tiny_free_class(void *ptr, size_t class_index);
+size_t mem_tiny_size(void *ptr);
+void mem_tiny_flush(void);
+size_t mem_tiny_class_size(size_t class_index);
+size_t mem_tiny_per_run(size_t class_index);
+void mem_tiny_for_each_run(void (*visit)(mem_tiny_run_t *run, void *arg), void *arg);
+void mem_tiny_lock_all(void);
+void mem_tiny_unlock_all(void);
+
+/* ========================================================================== */
+/* PAGE PURGING */
+/* ========================================================================== */
+
+/*
+ * A free block flagged MEM_BLOCK_CLEAN holds only zero bytes between its
+ * first MEM_CLEAN_OFFSET bytes and its footer: its pages were never
+ * touched or were returned with madvise. Dirty free blocks of at least
+ * MEM_PURGE_MIN_SIZE keep the time they became dirty right after their
+ * bin links, and are purged once that time is older than the decay.
+ */
+#define MEM_PURGE_MIN_SIZE      (16 * 1024)
+#define MEM_PURGE_TICKS         4              /* purge passes per decay period */
+#define MEM_PURGE_CLEAN         UINT64_MAX     /* dirty-since value of clean blocks */
+
+typedef struct mem_purge_node {
+    mem_free_node_t links;
+    uint64_t dirty_since;
+} mem_purge_node_t;
+
+#define MEM_CLEAN_OFFSET        sizeof(mem_purge_node_t)
+
+uint64_t mem_clock_ms(void);
+uint64_t mem_block_dirty_since(mem_block_t *block);
+void mem_block_set_dirty_since(mem_block_t *block, uint64_t since);
+uint64_t mem_purge_merged_since(mem_block_t *block, mem_block_t *next);
+size_t mem_purge_block(mem_block_t *block);
+void mem_heap_purge(mem_heap_t *heap, uint64_t now, long decay_ms);
+void mem_heap_maybe_purge(mem_heap_t *heap);
+int mem_purge_start_background(void);
+void mem_purge_stop_background(void);
+void mem_purge_reset_after_fork(void);
+
+/* ========================================================================== */
+/* LARGE MAPPINGS */
+/* ========================================================================== */
+
+/*
+ * Requests of at least mem_mmap_threshold bytes get a private mapping of
+ * their own, tracked in a locked list and unmapped on free. Lookups only
+ * trust pointers the page map names as the payload of a mapping, so
+ * stray pointers are never read. Aligned mappings take a power-of-two
+ * alignment above MEM_ALIGNMENT.
+ */
+void* mem_mmap_alloc(size_t size);
+void* mem_mmap_alloc_aligned(size_t size, size_t alignment);
+bool mem_mmap_free(void *ptr);
+void* mem_mmap_realloc(void *ptr, size_t size);
+size_t mem_mmap_size(void *ptr);
+void mem_mmap_release_all(void);
+size_t mem_mmap_count(void);
+void mem_mmap_for_each(void (*visit)(mem_block_t *block, void *arg), void *arg);
+void mem_mmap_lock(void);
+void mem_mmap_unlock(void);
+
+/* ========================================================================== */
+/* OBJECT POOLS */
+/* ========================================================================== */
+
+/*
+ * Pool slabs are power-of-two sized and aligned, hold at least
+ * MEM_POOL_MIN_OBJECTS objects and never exceed MEM_POOL_MAX_SLAB, so
+ * pools accept alignments up to MEM_POOL_MAX_SLAB / MEM_POOL_MIN_OBJECTS.
+ */
+#define MEM_POOL_MIN_OBJECTS    8
+#define MEM_POOL_MAX_SLAB       (256 * 1024)
+
+void mem_pool_for_each(void (*visit)(mem_pool_t *pool, void *arg), void *arg);
+void mem_pool_forget_all(void);
+
+/* ========================================================================== */
+/* ARENAS */
+/* ========================================================================== */
+
+void mem_arena_for_each(void (*visit)(mem_arena_t *arena, void *arg), void *arg);
+void mem_arena_forget_all(void);
+
+/* ========================================================================== */
+/* FORK */
+/* ========================================================================== */
+
+/*
+ * pthread_atfork handlers. mem_fork_prepare takes the init lock, every
+ * heap lock, the tiny locks and the mapping lock in that order, so no
+ * allocator lock is held by another thread at the moment of fork. The
+ * child also forgets the background purge thread, which fork does not
+ * copy, and purges inline from then on.
+ */
+void mem_fork_prepare(void);
+void mem_fork_parent(void);
+void mem_fork_child(void);
+
+/* ========================================================================== */
+/* REMOTE FREES */
+/* ========================================================================== */
+
+/*
+ * Multi-producer, single-consumer stack of blocks freed from outside the
+ * owning heap. Any thread may push; only the holder of the heap lock
+ * drains. Pushed blocks reuse the thread cache entry layout and key.
+ */
+void mem_remote_free_push(mem_heap_t *heap, mem_block_t *block);
+size_t mem_remote_free_drain(mem_heap_t *heap);
 
 /* ========================================================================== */
 /* INTERNAL UTILITY FUNCTIONS */
 /* ========================================================================== */
 
 size_t mem_align_size(size_t size);
-mem_block_t* mem_find_free_block(size_t size);
-mem_block_t* mem_split_block(mem_block_t *block, size_t size);
-void mem_merge_blocks(mem_block_t *block);
-bool mem_is_valid_ptr(void *ptr);
+size_t mem_page_align(size_t size);
+mem_block_t* mem_find_free_block(mem_heap_t *heap, size_t size);
+mem_block_t* mem_split_block(mem_heap_t *heap, mem_block_t *block, size_t size);
+size_t mem_carve_blocks(mem_heap_t *heap, mem_block_t *block, size_t size, void **ptrs, size_t count);
+mem_block_t* mem_merge_blocks(mem_heap_t *heap, mem_block_t *block);
+bool mem_is_valid_ptr(mem_heap_t *heap, void *ptr);
+mem_block_t* mem_heap_allocate(mem_heap_t *heap, size_t size);
+mem_block_t* mem_heap_allocate_clean(mem_heap_t *heap, size_t size, bool *clean);
+mem_block_t* mem_heap_allocate_aligned(mem_heap_t *heap, size_t size, size_t alignment);
+size_t mem_heap_allocate_batch(mem_heap_t *heap, size_t size, void **ptrs, size_t count);
+void mem_heap_release(mem_heap_t *heap, mem_block_t *block);
+void mem_heap_free_block(mem_heap_t *heap, mem_block_t *block, size_t size, bool remote);
 void* mem_block_to_ptr(mem_block_t *block);
 mem_block_t* mem_ptr_to_block(void *ptr);
+mem_block_t* mem_next_block(mem_block_t *block);
+mem_block_t* mem_prev_free_block(mem_block_t *block);
+void mem_block_mark_free(mem_block_t *block);
+void mem_block_mark_used(mem_block_t *block);
+
+size_t mem_bin_index(size_t size);
+void mem_bin_insert(mem_heap_t *heap, mem_block_t *block);
+void mem_bin_remove(mem_heap_t *heap, mem_block_t *block);
+void mem_bins_reset(mem_heap_t *heap);
+
+void mem_tree_insert(mem_block_t **root, mem_block_t *block);
+void mem_tree_remove(mem_block_t **root, mem_block_t *block);
+mem_block_t* mem_tree_best_fit(mem_block_t *root, size_t size);
+mem_block_t* mem_tree_largest(mem_block_t *root);
+void mem_tree_for_each(mem_block_t *root, void (*visit)(mem_block_t *block, void *arg), void *arg);
+
+/* ========================================================================== */
+/* STATISTICS */
+/* ========================================================================== */
+
+/*
+ * Allocation counters live in a cache-line aligned thread-local block
+ * that only its thread writes, so the fast paths share no counter line.
+ * mem_get_stats sums the blocks of the live threads and the totals left
+ * by exited ones. Peak usage is tracked on mem_published_usage, to which
+ * a thread adds its own usage only after it moved by MEM_STATS_PUBLISH
+ * bytes, so the peak may miss up to that much per thread. The thread
+ * cache and the tiny magazines keep their list lengths in the same block
+ * as per-class counts of blocks handed out and taken back, which the
+ * statistics read as they are: a cached malloc or free writes nothing
+ * else. Their usage is published whenever a cache takes a batch.
+ */
+#define MEM_CACHE_LINE          64
+#define MEM_STATS_PUBLISH       (256 * 1024)
+
+/* Counters a thread owns */
+typedef struct mem_stats_counters {
+    size_t num_allocations;
+    size_t total_allocated;
+    size_t num_frees;
+    size_t total_freed;
+    size_t shrunk;              /* given back by in-place shrinking */
+    size_t published;           /* usage already added to mem_published_usage */
+    size_t published_caches;
+    size_t requests[MEM_STATS_CLASSES];
+} mem_stats_counters_t;
+
+/* One cache list: it holds spare + frees - allocs blocks */
+typedef struct mem_cache_counts {
+    size_t allocs;
+    size_t frees;
+    size_t spare;               /* taken from the heap minus given back, in batches */
+} mem_cache_counts_t;
+
+typedef struct mem_thread_stats {
+    mem_stats_counters_t counters;
+    mem_cache_counts_t tcache[MEM_TCACHE_CLASSES];
+    mem_cache_counts_t tiny[MEM_TINY_CLASSES];
+    unsigned tcache_generation;         /* mem_generation the counts belong to */
+    unsigned tiny_generation;
+    struct mem_thread_stats *prev;
+    struct mem_thread_stats *next;
+    bool registered;
+} __attribute__((aligned(MEM_CACHE_LINE))) mem_thread_stats_t;
+
+extern __thread mem_thread_stats_t mem_thread_stats;
+extern bool mem_stats_enabled;
+
+void mem_stats_register_thread(void);
+void mem_stats_restart_cache(mem_cache_counts_t *counts, size_t classes, unsigned *generation);
+void mem_stats_publish_caches(void);
+void mem_stats_record_allocations(size_t count, size_t bytes);
+void mem_stats_record_frees(size_t count, size_t bytes);
+void mem_stats_record_shrink(size_t size);
+void mem_stats_record_growth(size_t size);
+size_t mem_stats_class(size_t size);
+void mem_stats_reset(void);
+void mem_stats_lock(void);
+void mem_stats_unlock(void);
+
+/* Only the owning thread writes its counters, so no read-modify-write is needed */
+static inline void mem_stats_bump(size_t *counter, size_t amount)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+static inline mem_thread_stats_t* mem_stats_current(void)
+{
+    if (!mem_thread_stats.registered) {
+        mem_stats_register_thread();
+    }
+    return &mem_thread_stats;
+}
+
+static inline size_t mem_cache_fill(const mem_cache_counts_t *counts)
+{
+    return counts->spare + counts->frees - counts->allocs;
+}
+
+static inline void mem_stats_record_allocation(size_t size)
+{
+    if (mem_stats_enabled) {
+        mem_stats_record_allocations(1, size);
+    }
+}
+
+static inline void mem_stats_record_free(size_t size)
+{
+    if (mem_stats_enabled) {
+        mem_stats_record_frees(1, size);
+    }
+}
+
+/* ========================================================================== */
+/* LEAK TRACKING */
+/* ========================================================================== */
+
+/*
+ * MALLOC and FREE in DEBUG builds record live blocks in an open-addressing
+ * table keyed by pointer, mapped on first use and never resized. Once it
+ * is MEM_LEAK_TABLE_LOAD percent full, further blocks are counted but not
+ * recorded. mem_detect_leaks groups the recorded blocks by call site.
+ */
+#define MEM_LEAK_TABLE_BITS     16             /* 65536 slots */
+#define MEM_LEAK_TABLE_LOAD     75
+#define MEM_LEAK_SITE_BITS      10             /* distinct call sites grouped */
+#define MEM_LEAK_REPORT_SITES   20             /* largest sites printed */
+
+void mem_leak_track(void *ptr, size_t size, const char *file, int line);
+void mem_leak_untrack(void *ptr);
+bool mem_leak_is_tracked(void *ptr);
+bool mem_leak_report_sites(void);
+void mem_leak_reset(void);
+void mem_leak_lock(void);
+void mem_leak_unlock(void);
+
+/* ========================================================================== */
+/* HEAP PROFILING */
+/* ========================================================================== */
+
+/*
+ * Each thread counts down the bytes it allocates, and mem_malloc and
+ * mem_calloc only leave their fast paths when the count drops below zero.
+ * A sampled block gets a large mapping of its own, so the free paths
+ * already route it to mem_mmap_free, and the mapping names the bucket
+ * that aggregates the samples of one allocation stack.
+ */
+#define MEM_SAMPLE_DEPTH        32             /* frames kept per stack */
+#define MEM_SAMPLE_BUCKET_BITS  12             /* distinct stacks kept */
+#define MEM_SAMPLE_RECHECK      (1024 * 1024)  /* bytes between checks while disabled */
+
+typedef struct mem_sample_bucket mem_sample_bucket_t;
+
+extern __thread ptrdiff_t mem_sample_countdown;
+
+void* mem_sample_alloc(size_t size);
+void mem_sample_release(mem_sample_bucket_t *bucket, size_t size);
+void mem_sample_reset(void);
+void mem_sample_lock(void);
+void mem_sample_unlock(void);
+void* mem_mmap_alloc_sampled(size_t size, mem_sample_bucket_t *bucket);
+
+static inline bool mem_sample_due(size_t size)
+{
+    mem_sample_countdown -= (ptrdiff_t)size;
+    return mem_sample_countdown < 0;
+}
 
 /* ========================================================================== */
 /* INTERNAL GLOBALS */
 /* ========================================================================== */
 
-extern void *heap_start;
-extern void *heap_end;
-extern mem_block_t *first_block;
-extern mem_stats_t global_stats;
-extern mem_leak_t *leak_list;
+extern mem_heap_t mem_heaps[MEM_MAX_HEAPS];
+extern size_t mem_heap_count;
+extern size_t mem_heap_size;
+extern size_t mem_heap_reserve;
+extern size_t mem_mmap_threshold;
+extern long mem_decay_ms;
+extern bool mem_background_purge;
+extern size_t mem_sample_interval;
+extern unsigned mem_generation;
+extern pthread_mutex_t mem_init_lock;
+extern mem_stats_t global_stats;      /* only peak_usage and purged_bytes */
+extern size_t mem_published_usage;
+extern uintptr_t mem_tcache_key;
+extern mem_cache_mode_t mem_cache_mode;
 
 #endif /* MEM_UTILS_H */
@@ -14,7 +14,21 @@
  * - mem_malloc.c: Memory allocation implementation
  * - mem_free.c: Memory deallocation implementation
  * - mem_realloc.c: Memory reallocation implementation
+ * - mem_sized.c: Sized deallocation that trusts the caller's size
+ * - mem_batch.c: Batch allocation and sorted batch frees
  * - mem_calloc.c: Zeroed memory allocation implementation
+ * - mem_aligned.c: Over-aligned allocation entry points
+ * - mem_pool.c: Fixed-size object pools carved from slabs
+ * - mem_arena.c: Bump-allocating arenas with markers and bulk reset
+ * - mem_heaps.c: Thread-to-heap binding and pointer-to-heap lookup
+ * - mem_growth.c: Committing more of a heap's reserved range on demand
+ * - mem_mmap.c: Dedicated mappings for large allocations
+ * - mem_tiny.c: Headerless bitmap runs for objects up to 64 bytes
+ * - mem_fork.c: Fork handlers that keep allocator locks consistent
+ * - mem_decay.c: Decay-based purging of free pages
+ * - mem_tcache.c: Per-thread small block caches
+ * - mem_percpu.c: Optional rseq-based per-CPU small block caches
+ * - mem_remote_free.c: Lock-free stacks of blocks freed by other threads
  * 
  * ============================================================================
  */
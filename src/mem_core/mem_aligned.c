@@ -0,0 +1,98 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Aligned Allocation
+ * ============================================================================
+ * 
+ * This file implements mem_aligned_alloc, mem_memalign and
+ * mem_posix_memalign. Alignments up to MEM_ALIGNMENT are plain mem_malloc
+ * calls. Larger ones are carved from a heap under its lock: the gap in
+ * front of the aligned payload is split off as a free block and the tail
+ * past the requested size is split off as usual, so nothing is wasted.
+ * Requests at or above mem_mmap_threshold get a mapping of their own, as
+ * plain ones do, with the payload placed on the alignment inside it.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <errno.h>
+
+static bool is_power_of_two(size_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static void* aligned_from_heap(mem_heap_t *heap, size_t size, size_t alignment)
+{
+    void *ptr = NULL;
+    
+    pthread_mutex_lock(&heap->lock);
+    mem_block_t *block = mem_heap_allocate_aligned(heap, size, alignment);
+    if (block != NULL) {
+        mem_stats_record_allocation(mem_block_size(block));
+        ptr = mem_block_to_ptr(block);
+    }
+    pthread_mutex_unlock(&heap->lock);
+    
+    return ptr;
+}
+
+static void* allocate_aligned(size_t size, size_t alignment)
+{
+    mem_heap_t *home = mem_thread_heap();
+    size_t count = __atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE);
+    void *ptr = NULL;
+    
+    if (home == NULL || size >= mem_heap_reserve || alignment >= mem_heap_reserve) {
+        return NULL;
+    }
+    
+    ptr = aligned_from_heap(home, size, alignment);
+    for (size_t i = 0; ptr == NULL && i < count; i++) {
+        mem_heap_t *heap = mem_heap_get(i);
+        if (heap != NULL && heap != home) {
+            ptr = aligned_from_heap(heap, size, alignment);
+        }
+    }
+    return ptr;
+}
+
+void* mem_aligned_alloc(size_t alignment, size_t size)
+{
+    if (size == 0 || size > SIZE_MAX / 2 || !is_power_of_two(alignment)) {
+        return NULL;
+    }
+    if (alignment <= MEM_ALIGNMENT) {
+        return mem_malloc(size);
+    }
+    
+    size = mem_align_size(size);
+    if (size >= mem_mmap_threshold) {
+        return mem_mmap_alloc_aligned(size, alignment);
+    }
+    return allocate_aligned(size, alignment);
+}
+
+void* mem_memalign(size_t alignment, size_t size)
+{
+    return mem_aligned_alloc(alignment, size);
+}
+
+int mem_posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    if (!is_power_of_two(alignment) || alignment % sizeof(void*) != 0) {
+        return EINVAL;
+    }
+    if (size == 0) {
+        *memptr = NULL;
+        return 0;
+    }
+    
+    void *ptr = mem_aligned_alloc(alignment, size);
+    if (ptr == NULL) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
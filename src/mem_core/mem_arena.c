@@ -0,0 +1,225 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Arenas
+ * ============================================================================
+ * 
+ * This file implements region allocation. An arena bump-allocates from a
+ * stack of chunks taken from the main heap with mem_malloc; a request
+ * that does not fit the top chunk pushes a new one of at least the
+ * arena's chunk size. Objects are never freed one by one: a marker saved
+ * with mem_arena_save rolls the arena back to that point, and
+ * mem_arena_reset / mem_arena_destroy drop everything, all in O(chunks).
+ * Reset keeps the oldest chunk for the next round. An arena belongs to
+ * one thread at a time, but statistics and leak reports may inspect it
+ * from any thread: the arena's lock covers its chunk stack, which only
+ * changes when a chunk is pushed or popped, and chunk fill levels are
+ * read atomically, so bump allocation stays lock-free. The registry of
+ * live arenas has its own lock.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+typedef struct mem_arena_chunk {
+    struct mem_arena_chunk *prev;
+    size_t capacity;
+    size_t used;
+} mem_arena_chunk_t;
+
+struct mem_arena {
+    pthread_mutex_t lock;               /* held while the chunk stack changes */
+    mem_arena_chunk_t *top;
+    size_t chunk_size;
+    size_t chunk_count;
+    size_t chunk_bytes;
+    struct mem_arena *prev_arena;
+    struct mem_arena *next_arena;
+};
+
+#define CHUNK_HEADER_SIZE   ((sizeof(mem_arena_chunk_t) + MEM_ALIGNMENT - 1) & ~(size_t)(MEM_ALIGNMENT - 1))
+
+static mem_arena_t *arenas = NULL;
+static pthread_mutex_t arenas_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ========================================================================== */
+/* ARENA REGISTRY */
+/* ========================================================================== */
+
+static void register_arena(mem_arena_t *arena)
+{
+    pthread_mutex_lock(&arenas_lock);
+    arena->prev_arena = NULL;
+    arena->next_arena = arenas;
+    if (arenas != NULL) {
+        arenas->prev_arena = arena;
+    }
+    arenas = arena;
+    pthread_mutex_unlock(&arenas_lock);
+}
+
+static void unregister_arena(mem_arena_t *arena)
+{
+    pthread_mutex_lock(&arenas_lock);
+    if (arena->prev_arena != NULL) {
+        arena->prev_arena->next_arena = arena->next_arena;
+    } else {
+        arenas = arena->next_arena;
+    }
+    if (arena->next_arena != NULL) {
+        arena->next_arena->prev_arena = arena->prev_arena;
+    }
+    pthread_mutex_unlock(&arenas_lock);
+}
+
+void mem_arena_for_each(void (*visit)(mem_arena_t *arena, void *arg), void *arg)
+{
+    pthread_mutex_lock(&arenas_lock);
+    for (mem_arena_t *arena = arenas; arena != NULL; arena = arena->next_arena) {
+        visit(arena, arg);
+    }
+    pthread_mutex_unlock(&arenas_lock);
+}
+
+/* Arenas live in the heaps, so mem_cleanup only has to drop the list */
+void mem_arena_forget_all(void)
+{
+    pthread_mutex_lock(&arenas_lock);
+    arenas = NULL;
+    pthread_mutex_unlock(&arenas_lock);
+}
+
+/* ========================================================================== */
+/* CHUNKS */
+/* ========================================================================== */
+
+static mem_arena_chunk_t* push_chunk(mem_arena_t *arena, size_t size)
+{
+    size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+    mem_arena_chunk_t *chunk = mem_malloc(CHUNK_HEADER_SIZE + capacity);
+    
+    if (chunk == NULL) {
+        return NULL;
+    }
+    
+    chunk->prev = arena->top;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    pthread_mutex_lock(&arena->lock);
+    arena->top = chunk;
+    arena->chunk_count++;
+    arena->chunk_bytes += capacity;
+    pthread_mutex_unlock(&arena->lock);
+    return chunk;
+}
+
+static void pop_chunk(mem_arena_t *arena)
+{
+    mem_arena_chunk_t *chunk = arena->top;
+    
+    pthread_mutex_lock(&arena->lock);
+    arena->top = chunk->prev;
+    arena->chunk_count--;
+    arena->chunk_bytes -= chunk->capacity;
+    pthread_mutex_unlock(&arena->lock);
+    mem_free(chunk);
+}
+
+/* ========================================================================== */
+/* PUBLIC INTERFACE */
+/* ========================================================================== */
+
+mem_arena_t* mem_arena_create(size_t chunk_size)
+{
+    mem_arena_t *arena = mem_malloc(sizeof(mem_arena_t));
+    
+    if (arena == NULL) {
+        return NULL;
+    }
+    
+    pthread_mutex_init(&arena->lock, NULL);
+    arena->top = NULL;
+    arena->chunk_size = chunk_size != 0 ? chunk_size : MEM_ARENA_CHUNK_SIZE;
+    arena->chunk_count = 0;
+    arena->chunk_bytes = 0;
+    register_arena(arena);
+    return arena;
+}
+
+void mem_arena_destroy(mem_arena_t *arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    
+    unregister_arena(arena);
+    while (arena->top != NULL) {
+        pop_chunk(arena);
+    }
+    pthread_mutex_destroy(&arena->lock);
+    mem_free(arena);
+}
+
+void* mem_arena_alloc(mem_arena_t *arena, size_t size)
+{
+    if (arena == NULL || size == 0 || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    
+    size = (size + MEM_ALIGNMENT - 1) & ~(size_t)(MEM_ALIGNMENT - 1);
+    mem_arena_chunk_t *chunk = arena->top;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        chunk = push_chunk(arena, size);
+    }
+    if (chunk == NULL) {
+        return NULL;
+    }
+    
+    void *ptr = (char*)chunk + CHUNK_HEADER_SIZE + chunk->used;
+    __atomic_store_n(&chunk->used, chunk->used + size, __ATOMIC_RELAXED);
+    return ptr;
+}
+
+mem_arena_marker_t mem_arena_save(mem_arena_t *arena)
+{
+    mem_arena_marker_t marker = { arena->top, arena->top != NULL ? arena->top->used : 0 };
+    
+    return marker;
+}
+
+void mem_arena_restore(mem_arena_t *arena, mem_arena_marker_t marker)
+{
+    while (arena->top != NULL && (void*)arena->top != marker.chunk) {
+        pop_chunk(arena);
+    }
+    if (arena->top != NULL) {
+        __atomic_store_n(&arena->top->used, marker.used, __ATOMIC_RELAXED);
+    }
+}
+
+void mem_arena_reset(mem_arena_t *arena)
+{
+    while (arena->top != NULL && arena->top->prev != NULL) {
+        pop_chunk(arena);
+    }
+    if (arena->top != NULL) {
+        __atomic_store_n(&arena->top->used, 0, __ATOMIC_RELAXED);
+    }
+}
+
+void mem_arena_get_stats(mem_arena_t *arena, mem_arena_stats_t *stats)
+{
+    if (arena == NULL || stats == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&arena->lock);
+    stats->chunk_count = arena->chunk_count;
+    stats->chunk_bytes = arena->chunk_bytes;
+    stats->used_bytes = 0;
+    for (mem_arena_chunk_t *chunk = arena->top; chunk != NULL; chunk = chunk->prev) {
+        stats->used_bytes += __atomic_load_n(&chunk->used, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&arena->lock);
+}
@@ -0,0 +1,203 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Batch Allocation
+ * ============================================================================
+ * 
+ * This file implements mem_malloc_batch and mem_free_batch for callers
+ * that allocate many objects of one size and release them together.
+ * Tiny objects come straight from the runs of their class, and heap
+ * blocks are carved end to end from as few free blocks as possible,
+ * each under a single lock acquisition. Frees sort the pointers by
+ * address first: objects of one tiny class or one heap then sit next to
+ * each other and are released under one lock, and neighbouring heap
+ * blocks are joined before they go back to the bins, so a run of them
+ * costs a single merge. Both directions skip the thread caches and
+ * update the statistics once per batch.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+/* ========================================================================== */
+/* ALLOCATION */
+/* ========================================================================== */
+
+static size_t batch_from_heap(mem_heap_t *heap, size_t size, void **ptrs, size_t count)
+{
+    size_t filled = mem_heap_allocate_batch(heap, size, ptrs, count);
+    size_t bytes = 0;
+    
+    for (size_t i = 0; i < filled; i++) {
+        bytes += __atomic_load_n(&mem_ptr_to_block(ptrs[i])->header, __ATOMIC_RELAXED) & ~MEM_BLOCK_FLAGS;
+    }
+    mem_stats_record_allocations(filled, bytes);
+    return filled;
+}
+
+static size_t batch_from_heaps(size_t size, void **ptrs, size_t count)
+{
+    mem_heap_t *home = mem_thread_heap();
+    size_t heaps = __atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE);
+    
+    if (home == NULL) {
+        return 0;
+    }
+    
+    size_t filled = batch_from_heap(home, size, ptrs, count);
+    for (size_t i = 0; filled < count && i < heaps; i++) {
+        mem_heap_t *heap = mem_heap_get(i);
+        if (heap != NULL && heap != home) {
+            filled += batch_from_heap(heap, size, ptrs + filled, count - filled);
+        }
+    }
+    return filled;
+}
+
+size_t mem_malloc_batch(size_t size, size_t count, void **ptrs)
+{
+    size_t filled = 0;
+    
+    /* Aligning a size past PTRDIFF_MAX would wrap to a small one */
+    if (size == 0 || size > PTRDIFF_MAX || count == 0 || ptrs == NULL) {
+        return 0;
+    }
+    
+    if (size <= MEM_TINY_MAX) {
+        filled = mem_tiny_alloc_batch(size, ptrs, count);
+        mem_stats_record_allocations(filled, filled * mem_tiny_class_size((size - 1) / MEM_ALIGNMENT));
+    }
+    
+    size = mem_align_size(size);
+    if (filled == count) {
+        return filled;
+    }
+    if (size >= mem_mmap_threshold) {
+        while (filled < count && (ptrs[filled] = mem_mmap_alloc(size)) != NULL) {
+            filled++;
+        }
+        return filled;
+    }
+    return filled + batch_from_heaps(size, ptrs + filled, count - filled);
+}
+
+/* ========================================================================== */
+/* DEALLOCATION */
+/* ========================================================================== */
+
+static void sift_down(void **ptrs, size_t root, size_t count)
+{
+    for (size_t child = 2 * root + 1; child < count; root = child, child = 2 * root + 1) {
+        if (child + 1 < count && (uintptr_t)ptrs[child + 1] > (uintptr_t)ptrs[child]) {
+            child++;
+        }
+        if ((uintptr_t)ptrs[root] >= (uintptr_t)ptrs[child]) {
+            return;
+        }
+        void *swap = ptrs[root];
+        ptrs[root] = ptrs[child];
+        ptrs[child] = swap;
+    }
+}
+
+/* In-place heapsort: qsort may allocate, and this may run as malloc */
+static void sort_by_address(void **ptrs, size_t count)
+{
+    for (size_t i = count / 2; i > 0; i--) {
+        sift_down(ptrs, i - 1, count);
+    }
+    for (size_t end = count; end > 1; end--) {
+        void *swap = ptrs[0];
+        ptrs[0] = ptrs[end - 1];
+        ptrs[end - 1] = swap;
+        sift_down(ptrs, 0, end - 1);
+    }
+}
+
+static bool is_live_block(mem_heap_t *heap, void *ptr)
+{
+    return mem_is_valid_ptr(heap, ptr)
+        && !mem_block_is_free(mem_ptr_to_block(ptr))
+        && !mem_tcache_is_cached(mem_ptr_to_block(ptr));
+}
+
+/* Neighbouring blocks become one used block, released with a single merge */
+static size_t release_heap_group(mem_heap_t *heap, void **ptrs, size_t count, size_t *bytes)
+{
+    mem_block_t *run = NULL;
+    size_t freed = 0;
+    
+    pthread_mutex_lock(&heap->lock);
+    for (size_t i = 0; i < count; i++) {
+        if ((i > 0 && ptrs[i] == ptrs[i - 1]) || !is_live_block(heap, ptrs[i])) {
+            continue;
+        }
+        mem_block_t *block = mem_ptr_to_block(ptrs[i]);
+        *bytes += mem_block_size(block);
+        freed++;
+        if (run != NULL && mem_block_successor(run) == block) {
+            mem_block_set_size(run, mem_block_size(run) + MEM_HEADER_SIZE + mem_block_size(block));
+            heap->num_blocks--;
+            continue;
+        }
+        if (run != NULL) {
+            mem_heap_release(heap, run);
+        }
+        run = block;
+    }
+    if (run != NULL) {
+        mem_heap_release(heap, run);
+    }
+    pthread_mutex_unlock(&heap->lock);
+    
+    return freed;
+}
+
+static size_t release_group(mem_page_kind_t kind, void *owner, void **ptrs, size_t count, size_t *bytes)
+{
+    if (kind == MEM_PAGE_TINY) {
+        return mem_tiny_free_batch(ptrs, count, bytes);
+    }
+    if (kind == MEM_PAGE_HEAP) {
+        return release_heap_group(owner, ptrs, count, bytes);
+    }
+    for (size_t i = 0; kind == MEM_PAGE_MMAP && i < count; i++) {
+        mem_mmap_free(ptrs[i]);
+    }
+    return 0;
+}
+
+/* Length of the group starting at ptrs[0] that shares its owner */
+static size_t group_length(void **ptrs, size_t count, mem_page_kind_t kind, void *owner)
+{
+    size_t length = 1;
+    void *next_owner = NULL;
+    
+    while (length < count && mem_page_map_lookup(ptrs[length], &next_owner) == kind
+           && (kind == MEM_PAGE_TINY || next_owner == owner)) {
+        length++;
+    }
+    return length;
+}
+
+void mem_free_batch(void **ptrs, size_t count)
+{
+    size_t freed = 0;
+    size_t bytes = 0;
+    
+    if (ptrs == NULL || count == 0) {
+        return;
+    }
+    
+    sort_by_address(ptrs, count);
+    for (size_t i = 0; i < count;) {
+        void *owner = NULL;
+        mem_page_kind_t kind = mem_page_map_lookup(ptrs[i], &owner);
+        size_t length = group_length(ptrs + i, count - i, kind, owner);
+        
+        freed += release_group(kind, owner, ptrs + i, length, &bytes);
+        i += length;
+    }
+    mem_stats_record_frees(freed, bytes);
+}
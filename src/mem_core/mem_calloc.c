@@ -4,7 +4,12 @@
  * ============================================================================
  * 
  * This file implements the mem_calloc function with overflow protection
- * and zero-initialization of allocated memory.
+ * and zero-initialization of allocated memory. Requests above the mmap
+ * threshold get a fresh mapping, which the kernel already zeroed. Heap
+ * blocks carved from clean memory only need the bytes that held their
+ * free-block bookkeeping cleared, so their untouched pages are never
+ * faulted in. Everything else is cleared with memset. Sampled blocks
+ * are fresh mappings as well.
  * 
  * ============================================================================
  */
@@ -13,16 +18,72 @@
 #include "../../include/mem_utils.h"
 #include <string.h>
 
-void* mem_calloc(size_t nmemb, size_t size)
+static void zero_block(mem_block_t *block, size_t size, bool clean)
 {
-    size_t total_size = nmemb * size;
+    char *payload = mem_block_to_ptr(block);
+    
+    if (!clean) {
+        memset(payload, 0, size);
+        return;
+    }
+    memset(payload, 0, MEM_CLEAN_OFFSET);
+    memset(payload + mem_block_size(block) - MEM_FOOTER_SIZE, 0, MEM_FOOTER_SIZE);
+}
 
-    if (nmemb != 0 && total_size / nmemb != size) {
+static void* calloc_from_heap(mem_heap_t *heap, size_t size)
+{
+    bool clean = false;
+    
+    pthread_mutex_lock(&heap->lock);
+    mem_block_t *block = mem_heap_allocate_clean(heap, mem_align_size(size), &clean);
+    if (block != NULL) {
+        mem_stats_record_allocation(mem_block_size(block));
+    }
+    pthread_mutex_unlock(&heap->lock);
+    
+    if (block == NULL) {
         return NULL;
     }
-    void *ptr = mem_malloc(total_size);
+    zero_block(block, size, clean);
+    return mem_block_to_ptr(block);
+}
+
+static void* calloc_with_memset(size_t size)
+{
+    void *ptr = mem_malloc(size);
+    
     if (ptr != NULL) {
-        memset(ptr, 0, total_size);
+        memset(ptr, 0, size);
     }
     return ptr;
 }
+
+void* mem_calloc(size_t nmemb, size_t size)
+{
+    size_t total_size = nmemb * size;
+    
+    if (nmemb != 0 && total_size / nmemb != size) {
+        return NULL;
+    }
+    /* Aligning a total past PTRDIFF_MAX would wrap to a small size */
+    if (total_size > PTRDIFF_MAX) {
+        return NULL;
+    }
+    
+    mem_heap_t *heap = mem_thread_heap();
+    if (heap == NULL || mem_align_size(total_size) < MEM_SMALL_BIN_LIMIT) {
+        return calloc_with_memset(total_size);
+    }
+    if (mem_sample_due(total_size)) {
+        void *sampled = mem_sample_alloc(total_size);
+        if (sampled != NULL) {
+            return sampled;
+        }
+    }
+    if (mem_align_size(total_size) >= mem_mmap_threshold) {
+        return mem_mmap_alloc(mem_align_size(total_size));
+    }
+    
+    void *ptr = calloc_from_heap(heap, total_size);
+    return ptr != NULL ? ptr : calloc_with_memset(total_size);
+}
@@ -0,0 +1,163 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Decay-Based Purging
+ * ============================================================================
+ * 
+ * This file decides when free pages go back to the OS. A purge pass walks
+ * the size tree of a heap and purges every dirty block that has been
+ * free for at least the decay time, so memory reused within the decay
+ * window is never purged and faulted back in. Passes run MEM_PURGE_TICKS
+ * times per decay period, either from the heap release path or from an
+ * optional background thread; mem_purge forces a full pass right away.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <time.h>
+
+static pthread_t purge_thread;
+static pthread_mutex_t purge_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t purge_wakeup = PTHREAD_COND_INITIALIZER;
+static bool purge_running = false;
+
+static uint64_t purge_interval(void)
+{
+    uint64_t interval = (uint64_t)mem_decay_ms / MEM_PURGE_TICKS;
+    
+    return interval > 0 ? interval : 1;
+}
+
+static bool has_decayed(mem_block_t *block, uint64_t now, long decay_ms)
+{
+    uint64_t since;
+    
+    if (mem_block_size(block) < MEM_PURGE_MIN_SIZE) {
+        return false;
+    }
+    since = mem_block_dirty_since(block);
+    return since != MEM_PURGE_CLEAN && now - since >= (uint64_t)decay_ms;
+}
+
+typedef struct purge_pass {
+    mem_heap_t *heap;
+    uint64_t now;
+    long decay_ms;
+    size_t purged;
+} purge_pass_t;
+
+static void purge_if_decayed(mem_block_t *block, void *arg)
+{
+    purge_pass_t *pass = arg;
+    
+    size_t purged;
+    
+    if (has_decayed(block, pass->now, pass->decay_ms) && (purged = mem_purge_block(block)) > 0) {
+        pass->heap->dirty_bytes -= mem_block_size(block);
+        pass->purged += purged;
+    }
+}
+
+void mem_heap_purge(mem_heap_t *heap, uint64_t now, long decay_ms)
+{
+    purge_pass_t pass = { heap, now, decay_ms, 0 };
+    
+    mem_tree_for_each(heap->large_tree, purge_if_decayed, &pass);
+    __atomic_fetch_add(&global_stats.purged_bytes, pass.purged, __ATOMIC_RELAXED);
+}
+
+void mem_heap_maybe_purge(mem_heap_t *heap)
+{
+    if (mem_decay_ms < 0 || mem_background_purge) {
+        return;
+    }
+    
+    uint64_t now = mem_clock_ms();
+    if (mem_decay_ms > 0 && now < heap->next_purge) {
+        return;
+    }
+    heap->next_purge = now + purge_interval();
+    mem_heap_purge(heap, now, mem_decay_ms);
+}
+
+static void purge_decayed(mem_heap_t *heap, void *arg)
+{
+    mem_heap_purge(heap, mem_clock_ms(), *(long*)arg);
+}
+
+static void next_wake(struct timespec *wake)
+{
+    uint64_t interval = purge_interval();
+    
+    clock_gettime(CLOCK_REALTIME, wake);
+    wake->tv_sec += (time_t)(interval / 1000);
+    wake->tv_nsec += (long)(interval % 1000) * 1000000;
+    if (wake->tv_nsec >= 1000000000) {
+        wake->tv_sec++;
+        wake->tv_nsec -= 1000000000;
+    }
+}
+
+static void* purge_loop(void *arg)
+{
+    long decay_ms = mem_decay_ms;
+    struct timespec wake;
+    
+    (void)arg;
+    pthread_mutex_lock(&purge_lock);
+    while (purge_running) {
+        next_wake(&wake);
+        if (pthread_cond_timedwait(&purge_wakeup, &purge_lock, &wake) != 0 && purge_running) {
+            pthread_mutex_unlock(&purge_lock);
+            mem_for_each_heap(purge_decayed, &decay_ms);
+            pthread_mutex_lock(&purge_lock);
+        }
+    }
+    pthread_mutex_unlock(&purge_lock);
+    return NULL;
+}
+
+int mem_purge_start_background(void)
+{
+    purge_running = true;
+    if (pthread_create(&purge_thread, NULL, purge_loop, NULL) != 0) {
+        purge_running = false;
+        return -1;
+    }
+    return 0;
+}
+
+void mem_purge_stop_background(void)
+{
+    pthread_mutex_lock(&purge_lock);
+    bool running = purge_running;
+    purge_running = false;
+    pthread_cond_signal(&purge_wakeup);
+    pthread_mutex_unlock(&purge_lock);
+    
+    if (running) {
+        pthread_join(purge_thread, NULL);
+    }
+}
+
+/* Only the forking thread survives fork, so the child purges inline */
+void mem_purge_reset_after_fork(void)
+{
+    pthread_mutex_init(&purge_lock, NULL);
+    pthread_cond_init(&purge_wakeup, NULL);
+    purge_running = false;
+    mem_background_purge = false;
+}
+
+static void purge_everything(mem_heap_t *heap, void *arg)
+{
+    (void)arg;
+    mem_remote_free_drain(heap);
+    mem_heap_purge(heap, mem_clock_ms(), 0);
+}
+
+void mem_purge(void)
+{
+    mem_for_each_heap(purge_everything, NULL);
+}
@@ -0,0 +1,59 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Fork Handlers
+ * ============================================================================
+ * 
+ * This file implements the pthread_atfork handlers. A child process only
+ * keeps the thread that called fork, so any allocator lock held by
+ * another thread at that moment would stay locked in the child forever.
+ * The prepare handler therefore takes every lock the allocation paths
+ * use, in the order they nest; both parent and child release them once
+ * fork returns. Heaps only become ready under the init lock, which is
+ * taken first, so the set of heap locks cannot change in between.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+static void unlock_all(void)
+{
+    mem_sample_unlock();
+    mem_leak_unlock();
+    mem_stats_unlock();
+    mem_mmap_unlock();
+    mem_tiny_unlock_all();
+    for (size_t i = MEM_MAX_HEAPS; i > 0; i--) {
+        if (mem_heaps[i - 1].ready) {
+            pthread_mutex_unlock(&mem_heaps[i - 1].lock);
+        }
+    }
+    pthread_mutex_unlock(&mem_init_lock);
+}
+
+void mem_fork_prepare(void)
+{
+    pthread_mutex_lock(&mem_init_lock);
+    for (size_t i = 0; i < MEM_MAX_HEAPS; i++) {
+        if (mem_heaps[i].ready) {
+            pthread_mutex_lock(&mem_heaps[i].lock);
+        }
+    }
+    mem_tiny_lock_all();
+    mem_mmap_lock();
+    mem_stats_lock();
+    mem_leak_lock();
+    mem_sample_lock();
+}
+
+void mem_fork_parent(void)
+{
+    unlock_all();
+}
+
+void mem_fork_child(void)
+{
+    unlock_all();
+    mem_purge_reset_after_fork();
+}
@@ -4,7 +4,13 @@
  * ============================================================================
  * 
  * This file implements the mem_free function with block validation,
- * statistics tracking, and block merging.
+ * statistics tracking, and block merging. In per-CPU cache mode small
+ * blocks go to the current CPU's cache whatever heap owns them.
+ * Otherwise blocks owned by the calling thread's heap are parked in its
+ * cache when small, or returned under the heap lock. Blocks owned by
+ * another heap are pushed on that heap's remote free stack without
+ * locking. Pointers outside every heap may be large mappings, which are
+ * unmapped.
  * 
  * ============================================================================
  */
@@ -12,28 +18,78 @@
 #include "../../include/mem_alloc.h"
 #include "../../include/mem_utils.h"
 
+void mem_heap_release(mem_heap_t *heap, mem_block_t *block)
+{
+    mem_block_mark_free(block);
+    mem_block_set_dirty_since(block, mem_clock_ms());
+    mem_merge_blocks(heap, block);
+    mem_heap_maybe_purge(heap);
+}
+
+/*
+ * Another thread's cache, a remote stack or a CPU cache may hold the
+ * block, and none of them can be walked from here, so the key decides
+ */
+static bool is_double_free(mem_block_t *block, size_t header)
+{
+    return (header & MEM_BLOCK_FREE) != 0 || mem_tcache_is_cached(block);
+}
+
+static void release_block(mem_heap_t *heap, mem_block_t *block)
+{
+    pthread_mutex_lock(&heap->lock);
+    if (!mem_block_is_free(block)) {
+        mem_heap_release(heap, block);
+    }
+    pthread_mutex_unlock(&heap->lock);
+}
+
+/* Hands a live block of the given size to its cache, its heap or its remote stack */
+void mem_heap_free_block(mem_heap_t *heap, mem_block_t *block, size_t size, bool remote)
+{
+    if (mem_cache_mode == MEM_CACHE_PER_CPU && mem_percpu_free(block, size)) {
+        mem_stats_record_free(size);
+        return;
+    }
+    /* The thread cache counts what it takes itself */
+    if (!remote && mem_tcache_free(block, size)) {
+        return;
+    }
+    
+    mem_stats_record_free(size);
+    if (remote) {
+        mem_remote_free_push(heap, block);
+    } else {
+        release_block(heap, block);
+    }
+}
+
 void mem_free(void *ptr)
 {
     if (ptr == NULL) {
         return;
     }
     
-    if (!mem_is_valid_ptr(ptr)) {
+    if (mem_tiny_owns(ptr)) {
+        mem_tiny_free(ptr);
         return;
     }
     
-    mem_block_t *block = mem_ptr_to_block(ptr);
-    
-    if (block->magic != MEM_MAGIC_ALLOCATED) {
+    mem_heap_t *heap = mem_heap_of(ptr);
+    if (heap == NULL) {
+        mem_mmap_free(ptr);
+        return;
+    }
+    if (!mem_is_valid_ptr(heap, ptr)) {
         return;
     }
     
-    block->is_free = true;
-    block->magic = MEM_MAGIC_FREE;
-    
-    global_stats.total_freed += block->size;
-    global_stats.current_usage -= block->size;
-    global_stats.num_frees++;
+    mem_block_t *block = mem_ptr_to_block(ptr);
+    size_t header = __atomic_load_n(&block->header, __ATOMIC_RELAXED);
+    bool remote = heap != mem_thread_heap();
+    if (is_double_free(block, header)) {
+        return;
+    }
     
-    mem_merge_blocks(block);
+    mem_heap_free_block(heap, block, header & ~MEM_BLOCK_FLAGS, remote);
 }
@@ -13,18 +13,40 @@
 #include "../../include/mem_utils.h"
 
 // Global variables for the memory allocator
-void *heap_start = NULL;
-void *heap_end = NULL;
-mem_block_t *first_block = NULL;
+mem_heap_t mem_heaps[MEM_MAX_HEAPS];
+size_t mem_heap_count = 0;
+size_t mem_heap_size = 0;
+size_t mem_heap_reserve = 0;
+size_t mem_mmap_threshold = MEM_MMAP_THRESHOLD;
+long mem_decay_ms = MEM_DECAY_MS;
+bool mem_background_purge = false;
+size_t mem_sample_interval = 0;
+unsigned mem_generation = 0;
+pthread_mutex_t mem_init_lock = PTHREAD_MUTEX_INITIALIZER;
 mem_stats_t global_stats = {0};
-mem_leak_t *leak_list = NULL;
+size_t mem_published_usage = 0;
+bool mem_stats_enabled = true;
+uintptr_t mem_tcache_key = 0;
+mem_cache_mode_t mem_cache_mode = MEM_CACHE_PER_THREAD;
 
 size_t mem_get_block_size(void *ptr)
 {
-    if (!mem_is_valid_ptr(ptr)) {
-        return 0;
+    if (mem_tiny_owns(ptr)) {
+        return mem_tiny_size(ptr);
     }
     
-    mem_block_t *block = mem_ptr_to_block(ptr);
-    return block->size;
+    mem_heap_t *heap = mem_heap_of(ptr);
+    size_t size = 0;
+    
+    if (heap == NULL) {
+        return mem_mmap_size(ptr);
+    }
+    
+    pthread_mutex_lock(&heap->lock);
+    if (mem_is_valid_ptr(heap, ptr)) {
+        size = mem_block_size(mem_ptr_to_block(ptr));
+    }
+    pthread_mutex_unlock(&heap->lock);
+    
+    return size;
 }
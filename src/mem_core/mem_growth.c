@@ -0,0 +1,62 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Heap Growth
+ * ============================================================================
+ * 
+ * This file implements on-demand growth of a heap inside its reserved
+ * address range. Growing commits at least MEM_HEAP_GROWTH more bytes
+ * with mprotect right behind the current end; the old epilogue becomes
+ * the header of a new free block, which merges with a free top block,
+ * and a new epilogue closes the heap again. Fresh pages are clean.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <sys/mman.h>
+
+static size_t growth_for(mem_heap_t *heap, size_t size)
+{
+    size_t wanted = size + MEM_HEADER_SIZE;
+    size_t room = (size_t)((char*)heap->limit - (char*)heap->end);
+    
+    wanted = mem_page_align(wanted > MEM_HEAP_GROWTH ? wanted : MEM_HEAP_GROWTH);
+    return wanted < room ? wanted : room;
+}
+
+static void extend_top(mem_heap_t *heap, char *old_end, size_t growth)
+{
+    mem_block_t *block = (mem_block_t*)(old_end - MEM_HEADER_SIZE);
+    mem_block_t *epilogue = (mem_block_t*)(old_end + growth - MEM_HEADER_SIZE);
+    
+    epilogue->header = 0;
+    block->header = (growth - MEM_HEADER_SIZE) | (block->header & MEM_BLOCK_PREV_FREE);
+    __atomic_store_n(&heap->end, (void*)(old_end + growth), __ATOMIC_RELEASE);
+    heap->num_blocks++;
+    
+    mem_block_mark_free(block);
+    mem_block_set_dirty_since(block, MEM_PURGE_CLEAN);
+    mem_merge_blocks(heap, block);
+}
+
+int mem_heap_grow(mem_heap_t *heap, size_t size)
+{
+    char *old_end = heap->end;
+    size_t growth = growth_for(heap, size);
+    
+    if (growth < MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE) {
+        return -1;
+    }
+    
+    if (mem_page_map_set(old_end, growth, MEM_PAGE_HEAP, heap) != 0) {
+        return -1;
+    }
+    if (mprotect(old_end, growth, PROT_READ | PROT_WRITE) != 0) {
+        mem_page_map_clear(old_end, growth);
+        return -1;
+    }
+    
+    extend_top(heap, old_end, growth);
+    return 0;
+}
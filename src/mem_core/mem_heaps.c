@@ -0,0 +1,89 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Heap Selection
+ * ============================================================================
+ * 
+ * This file maps threads and pointers to heaps. Every thread is bound to
+ * one heap on its first allocation, round-robin over the heap count chosen
+ * by mem_init; heaps beyond the first are mapped lazily. The binding is
+ * dropped when mem_cleanup bumps the global generation. Pointers are
+ * mapped to heaps through the page map, which only knows committed
+ * heap pages.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+static __thread mem_heap_t *thread_heap = NULL;
+static __thread unsigned thread_generation = 0;
+static size_t next_heap = 0;
+
+static int ensure_initialized(void)
+{
+    if (__atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE) != 0) {
+        return 0;
+    }
+    
+    mem_init(MEM_HEAP_SIZE);
+    return __atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE) != 0 ? 0 : -1;
+}
+
+mem_heap_t* mem_heap_get(size_t index)
+{
+    mem_heap_t *heap = &mem_heaps[index];
+    
+    if (__atomic_load_n(&heap->ready, __ATOMIC_ACQUIRE)) {
+        return heap;
+    }
+    
+    pthread_mutex_lock(&mem_init_lock);
+    if (!heap->ready && mem_heap_count != 0) {
+        mem_heap_init(heap, mem_heap_size, mem_heap_reserve);
+    }
+    pthread_mutex_unlock(&mem_init_lock);
+    
+    return heap->ready ? heap : NULL;
+}
+
+mem_heap_t* mem_heap_of(void *ptr)
+{
+    void *owner;
+    
+    return mem_page_map_lookup(ptr, &owner) == MEM_PAGE_HEAP ? owner : NULL;
+}
+
+mem_heap_t* mem_thread_heap(void)
+{
+    unsigned generation = __atomic_load_n(&mem_generation, __ATOMIC_ACQUIRE);
+    
+    if (thread_heap != NULL && thread_generation == generation) {
+        return thread_heap;
+    }
+    
+    if (ensure_initialized() != 0) {
+        return NULL;
+    }
+    
+    size_t count = __atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE);
+    size_t index = __atomic_fetch_add(&next_heap, 1, __ATOMIC_RELAXED) % count;
+    mem_heap_t *heap = mem_heap_get(index);
+    
+    thread_heap = heap != NULL ? heap : mem_heap_get(0);
+    thread_generation = generation;
+    return thread_heap;
+}
+
+void mem_for_each_heap(void (*visit)(mem_heap_t *heap, void *arg), void *arg)
+{
+    for (size_t i = 0; i < MEM_MAX_HEAPS; i++) {
+        mem_heap_t *heap = &mem_heaps[i];
+        
+        if (__atomic_load_n(&heap->ready, __ATOMIC_ACQUIRE)) {
+            pthread_mutex_lock(&heap->lock);
+            visit(heap, arg);
+            pthread_mutex_unlock(&heap->lock);
+        }
+    }
+}
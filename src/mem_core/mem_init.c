@@ -4,11 +4,16 @@
  * ============================================================================
  * 
  * This file implements memory allocator initialization and cleanup functions.
- * Handles heap setup using mmap, initial block creation, and resource cleanup.
+ * Handles heap setup using mmap, initial block and epilogue creation, and
+ * resource cleanup. Each heap reserves its whole address range as
+ * PROT_NONE and only commits the initial heap size, whose pages it
+ * registers in the page map.
  * 
  * Functions:
  * - mem_init: Initialize the memory allocator with specified heap size
+ * - mem_init_config: Initialize with a heap size and cache mode
  * - mem_cleanup: Clean up allocator resources and unmap memory
+ * - mem_heap_init / mem_heap_destroy: Set up or tear down a single heap
  * 
  * ============================================================================
  */
@@ -17,69 +22,190 @@
 #include "../../include/mem_utils.h"
 #include <sys/mman.h>
 #include <string.h>
+#include <unistd.h>
+#include <time.h>
 
-static int setup_heap(size_t heap_size)
+static int setup_heap(mem_heap_t *heap, size_t heap_size, size_t reserve)
 {
-    heap_start = mmap(NULL, heap_size, PROT_READ | PROT_WRITE, 
-                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (heap_start == MAP_FAILED) {
-        heap_start = NULL;
+    heap->start = mmap(NULL, reserve, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (heap->start == MAP_FAILED) {
+        heap->start = NULL;
         return -1;
     }
-    heap_end = (char*)heap_start + heap_size;
+    
+    if (mprotect(heap->start, heap_size, PROT_READ | PROT_WRITE) != 0
+        || mem_page_map_set(heap->start, heap_size, MEM_PAGE_HEAP, heap) != 0) {
+        munmap(heap->start, reserve);
+        heap->start = NULL;
+        return -1;
+    }
+    heap->end = (char*)heap->start + heap_size;
+    heap->limit = (char*)heap->start + reserve;
     return 0;
 }
 
-static void initialize_first_block(size_t heap_size)
+static void initialize_first_block(mem_heap_t *heap)
 {
-    first_block = (mem_block_t*)heap_start;
-    first_block->size = heap_size - sizeof(mem_block_t);
-    first_block->is_free = true;
-    first_block->magic = MEM_MAGIC_FREE;
-    first_block->next = NULL;
-    first_block->prev = NULL;
-    
-    memset(&global_stats, 0, sizeof(mem_stats_t));
-    global_stats.num_blocks = 1;
+    mem_block_t *epilogue = (mem_block_t*)((char*)heap->end - MEM_HEADER_SIZE);
+    
+    heap->first_block = (mem_block_t*)((char*)heap->start + MEM_HEAP_PADDING);
+    heap->first_block->header = (size_t)((char*)epilogue - (char*)mem_block_to_ptr(heap->first_block));
+    epilogue->header = 0;
+    mem_block_mark_free(heap->first_block);
+    mem_block_set_dirty_since(heap->first_block, MEM_PURGE_CLEAN);
+    
+    heap->num_blocks = 1;
+    
+    mem_bins_reset(heap);
+    mem_bin_insert(heap, heap->first_block);
 }
 
-int mem_init(size_t heap_size)
+int mem_heap_init(mem_heap_t *heap, size_t heap_size, size_t reserve)
 {
-    if (heap_start != NULL) {
+    if (setup_heap(heap, heap_size, reserve) != 0) {
         return -1;
     }
     
-    if (setup_heap(heap_size) != 0) {
-        return -1;
+    pthread_mutex_init(&heap->lock, NULL);
+    heap->index = (size_t)(heap - mem_heaps);
+    heap->remote_frees = NULL;
+    heap->next_purge = 0;
+    initialize_first_block(heap);
+    __atomic_store_n(&heap->ready, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void mem_heap_destroy(mem_heap_t *heap)
+{
+    if (!heap->ready) {
+        return;
     }
     
-    initialize_first_block(heap_size);
-    return 0;
+    mem_page_map_clear(heap->start, (size_t)((char*)heap->end - (char*)heap->start));
+    munmap(heap->start, (size_t)((char*)heap->limit - (char*)heap->start));
+    pthread_mutex_destroy(&heap->lock);
+    memset(heap, 0, sizeof(mem_heap_t));
 }
 
-static void cleanup_leak_list(void)
+static void initialize_tcache_key(void)
 {
-    mem_leak_t *leak = leak_list;
-    while (leak != NULL) {
-        mem_leak_t *next = leak->next;
-        leak = next;
+    struct timespec now;
+    
+    if (mem_tcache_key != 0) {
+        return;
     }
-    leak_list = NULL;
+    
+    clock_gettime(CLOCK_REALTIME, &now);
+    mem_tcache_key = ((uintptr_t)&now ^ (uintptr_t)now.tv_nsec * 0x9E3779B97F4A7C15ULL) | 1;
+}
+
+static size_t default_heap_count(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t count = (cpus > 0 ? (size_t)cpus : 1) * MEM_HEAPS_PER_CPU;
+    
+    return count < MEM_MAX_HEAPS ? count : MEM_MAX_HEAPS;
+}
+
+static void select_cache_mode(mem_cache_mode_t requested)
+{
+    mem_cache_mode = MEM_CACHE_PER_THREAD;
+    if (requested == MEM_CACHE_PER_CPU && mem_percpu_init() == 0) {
+        mem_cache_mode = MEM_CACHE_PER_CPU;
+    }
+}
+
+static size_t threshold_for(const mem_config_t *config)
+{
+    size_t threshold = mem_align_size(config->mmap_threshold);
+    
+    return threshold > MEM_SMALL_BIN_LIMIT ? threshold : MEM_SMALL_BIN_LIMIT;
+}
+
+static void configure_purging(const mem_config_t *config)
+{
+    mem_decay_ms = config->decay_ms;
+    mem_background_purge = config->background_purge && config->decay_ms >= 0
+                           && mem_purge_start_background() == 0;
+}
+
+static size_t reserve_for(const mem_config_t *config, size_t heap_size)
+{
+    size_t reserve = mem_page_align(config->heap_reserve);
+    
+    return reserve > heap_size ? reserve : heap_size;
+}
+
+int mem_init_config(const mem_config_t *config)
+{
+    static const mem_config_t defaults = MEM_CONFIG_DEFAULT;
+    size_t heap_size, reserve;
+    int result = -1;
+    
+    config = config != NULL ? config : &defaults;
+    if (config->heap_size < MEM_HEAP_PADDING + 2 * MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE) {
+        return -1;
+    }
+    heap_size = mem_page_align(config->heap_size);
+    reserve = reserve_for(config, heap_size);
+    
+    pthread_mutex_lock(&mem_init_lock);
+    if (mem_heap_count == 0 && mem_heap_init(&mem_heaps[0], heap_size, reserve) == 0) {
+        initialize_tcache_key();
+        select_cache_mode(config->cache_mode);
+        mem_stats_reset();
+        mem_stats_enabled = !config->disable_stats;
+        mem_sample_reset();
+        mem_sample_interval = config->sample_interval;
+        mem_heap_size = heap_size;
+        mem_heap_reserve = reserve;
+        mem_mmap_threshold = threshold_for(config);
+        configure_purging(config);
+        mem_tiny_init();    /* on failure tiny requests use the heaps */
+        __atomic_store_n(&mem_heap_count, default_heap_count(), __ATOMIC_RELEASE);
+        result = 0;
+    }
+    pthread_mutex_unlock(&mem_init_lock);
+    
+    return result;
+}
+
+int mem_init(size_t heap_size)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    
+    config.heap_size = heap_size;
+    return mem_init_config(&config);
 }
 
 void mem_cleanup(void)
 {
-    if (heap_start == NULL) {
+    pthread_mutex_lock(&mem_init_lock);
+    if (mem_heap_count == 0) {
+        pthread_mutex_unlock(&mem_init_lock);
         return;
     }
     
-    size_t heap_size = (char*)heap_end - (char*)heap_start;
-    munmap(heap_start, heap_size);
+    mem_purge_stop_background();
+    mem_background_purge = false;
+    for (size_t i = 0; i < MEM_MAX_HEAPS; i++) {
+        mem_heap_destroy(&mem_heaps[i]);
+    }
+    mem_percpu_destroy();
+    mem_tiny_destroy();
+    mem_mmap_release_all();
+    mem_pool_forget_all();
+    mem_arena_forget_all();
+    mem_cache_mode = MEM_CACHE_PER_THREAD;
+    mem_stats_enabled = true;
+    mem_sample_interval = 0;
     
-    heap_start = NULL;
-    heap_end = NULL;
-    first_block = NULL;
-    memset(&global_stats, 0, sizeof(mem_stats_t));
+    __atomic_store_n(&mem_heap_count, 0, __ATOMIC_RELEASE);
+    mem_stats_reset();
+    mem_sample_reset();
+    __atomic_add_fetch(&mem_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mem_init_lock);
     
-    cleanup_leak_list();
+    mem_leak_reset();
 }
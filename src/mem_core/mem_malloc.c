@@ -3,8 +3,20 @@
  * MEMORY ALLOCATOR - Malloc Implementation
  * ============================================================================
  * 
- * This file implements the mem_malloc function with first-fit allocation
- * strategy, block splitting, and statistics tracking.
+ * This file implements the mem_malloc function with segregated-fit
+ * allocation, block splitting, and statistics tracking. Small sizes are
+ * served from the calling thread's (or CPU's) cache first; everything else runs
+ * under the lock of the thread's heap and falls back to the other heaps
+ * when that one is exhausted. Every locked allocation first merges back
+ * the blocks other threads have freed into the heap, and a heap whose
+ * bins cannot serve a request commits more of its reservation. Requests
+ * above the mmap threshold skip the heaps and get a mapping of their own.
+ * Over-aligned blocks are carved from a padded free block whose leading
+ * gap is split off and stays in the bins. Batches of equal blocks, for
+ * the thread caches and mem_malloc_batch, are carved end to end from as
+ * few free blocks as possible under a single lock acquisition. Before
+ * any of that, the allocation is charged to the thread's heap profile
+ * countdown, and the rare one that exhausts it is sampled instead.
  * 
  * ============================================================================
  */
@@ -13,47 +25,188 @@
 #include "../../include/mem_utils.h"
 #include <string.h>
 
-static void update_allocation_stats(size_t size)
+static mem_block_t* prepare_block(mem_heap_t *heap, mem_block_t *block, size_t size)
 {
-    global_stats.total_allocated += size;
-    global_stats.current_usage += size;
-    global_stats.num_allocations++;
+    mem_bin_remove(heap, block);
+    if (mem_block_size(block) >= size + MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE) {
+        mem_split_block(heap, block, size);
+    }
+    
+    mem_block_mark_used(block);
+    return block;
+}
+
+static mem_block_t* find_block(mem_heap_t *heap, size_t size)
+{
+    mem_block_t *block;
     
-    if (global_stats.current_usage > global_stats.peak_usage) {
-        global_stats.peak_usage = global_stats.current_usage;
+    mem_remote_free_drain(heap);
+    block = mem_find_free_block(heap, size);
+    if (block == NULL && mem_heap_grow(heap, size) == 0) {
+        block = mem_find_free_block(heap, size);
     }
+    return block;
 }
 
-static mem_block_t* prepare_block(mem_block_t *block, size_t size)
+/* Also reports whether the block was carved from clean memory */
+mem_block_t* mem_heap_allocate_clean(mem_heap_t *heap, size_t size, bool *clean)
 {
-    if (block->size > size + sizeof(mem_block_t) + MEM_MIN_BLOCK_SIZE) {
-        mem_split_block(block, size);
+    mem_block_t *block = find_block(heap, size);
+    
+    if (block == NULL) {
+        return NULL;
     }
     
-    block->is_free = false;
-    block->magic = MEM_MAGIC_ALLOCATED;
-    return block;
+    *clean = (block->header & MEM_BLOCK_CLEAN) != 0;
+    return prepare_block(heap, block, size);
 }
 
-void* mem_malloc(size_t size)
+mem_block_t* mem_heap_allocate(mem_heap_t *heap, size_t size)
+{
+    bool clean;
+    
+    return mem_heap_allocate_clean(heap, size, &clean);
+}
+
+/* Distance to the first aligned payload that leaves room for a free block before it */
+static size_t leading_gap(mem_block_t *block, size_t alignment)
 {
-    if (size == 0) {
+    uintptr_t payload = (uintptr_t)mem_block_to_ptr(block);
+    uintptr_t aligned = (payload + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    
+    while (aligned != payload && aligned - payload < MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE) {
+        aligned += alignment;
+    }
+    return (size_t)(aligned - payload);
+}
+
+mem_block_t* mem_heap_allocate_aligned(mem_heap_t *heap, size_t size, size_t alignment)
+{
+    mem_block_t *block = find_block(heap, size + alignment + MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE);
+    
+    if (block == NULL) {
         return NULL;
     }
     
-    if (heap_start == NULL && mem_init(MEM_HEAP_SIZE) != 0) {
+    size_t gap = leading_gap(block, alignment);
+    if (gap > 0) {
+        mem_bin_remove(heap, block);
+        mem_block_t *aligned = mem_split_block(heap, block, gap - MEM_HEADER_SIZE);
+        mem_bin_insert(heap, block);
+        block = aligned;
+    }
+    return prepare_block(heap, block, size);
+}
+
+/* Best fit for one block, so fragments go first; fresh space yields a whole row */
+static size_t carve_row(mem_heap_t *heap, size_t size, void **ptrs, size_t count)
+{
+    mem_block_t *block = find_block(heap, size);
+    
+    if (block == NULL) {
+        return 0;
+    }
+    mem_bin_remove(heap, block);
+    return mem_carve_blocks(heap, block, size, ptrs, count);
+}
+
+size_t mem_heap_allocate_batch(mem_heap_t *heap, size_t size, void **ptrs, size_t count)
+{
+    size_t filled = 0;
+    size_t carved;
+    
+    pthread_mutex_lock(&heap->lock);
+    while (filled < count && (carved = carve_row(heap, size, ptrs + filled, count - filled)) > 0) {
+        filled += carved;
+    }
+    pthread_mutex_unlock(&heap->lock);
+    
+    return filled;
+}
+
+/* The thread cache counts what it hands out itself */
+static void* allocate_cached(size_t size)
+{
+    if (mem_cache_mode == MEM_CACHE_PER_CPU) {
+        void *ptr = mem_percpu_alloc(size);
+        if (ptr != NULL) {
+            size_t header = __atomic_load_n(&mem_ptr_to_block(ptr)->header, __ATOMIC_RELAXED);
+            mem_stats_record_allocation(header & ~MEM_BLOCK_FLAGS);
+        }
+        return ptr;
+    }
+    return mem_tcache_alloc(size);
+}
+
+static void* allocate_from_heap(mem_heap_t *heap, size_t size)
+{
+    void *ptr = NULL;
+    
+    pthread_mutex_lock(&heap->lock);
+    mem_block_t *block = mem_heap_allocate(heap, size);
+    if (block != NULL) {
+        mem_stats_record_allocation(mem_block_size(block));
+        ptr = mem_block_to_ptr(block);
+    }
+    pthread_mutex_unlock(&heap->lock);
+    
+    return ptr;
+}
+
+static void* allocate_from_other_heaps(mem_heap_t *home, size_t size)
+{
+    size_t count = __atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE);
+    
+    for (size_t i = 0; i < count; i++) {
+        mem_heap_t *heap = mem_heap_get(i);
+        if (heap != NULL && heap != home) {
+            void *ptr = allocate_from_heap(heap, size);
+            if (ptr != NULL) {
+                return ptr;
+            }
+        }
+    }
+    return NULL;
+}
+
+void* mem_malloc(size_t size)
+{
+    /* No object may exceed PTRDIFF_MAX, and aligning a larger size would wrap */
+    if (size == 0 || size > PTRDIFF_MAX) {
         return NULL;
     }
     
+    if (mem_sample_due(size)) {
+        void *sampled = mem_sample_alloc(size);
+        if (sampled != NULL) {
+            return sampled;
+        }
+    }
+    
+    if (size <= MEM_TINY_MAX) {
+        void *tiny = mem_tiny_alloc(size);
+        if (tiny != NULL) {
+            return tiny;
+        }
+    }
+    
     size = mem_align_size(size);
-    mem_block_t *block = mem_find_free_block(size);
+    if (size < MEM_SMALL_BIN_LIMIT) {
+        void *cached = allocate_cached(size);
+        if (cached != NULL) {
+            return cached;
+        }
+    }
     
-    if (block == NULL) {
+    mem_heap_t *heap = mem_thread_heap();
+    if (heap == NULL) {
         return NULL;
     }
     
-    prepare_block(block, size);
-    update_allocation_stats(size);
+    if (size >= mem_mmap_threshold) {
+        return mem_mmap_alloc(size);
+    }
     
-    return mem_block_to_ptr(block);
+    void *ptr = allocate_from_heap(heap, size);
+    return ptr != NULL ? ptr : allocate_from_other_heaps(heap, size);
 }
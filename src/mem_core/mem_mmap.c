@@ -0,0 +1,328 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Large Mappings
+ * ============================================================================
+ * 
+ * This file implements the direct mmap path for large requests. Each
+ * request at or above mem_mmap_threshold gets a private mapping, so it
+ * never fragments a heap and goes straight back to the OS on mem_free.
+ * Reallocating a mapping uses mremap, which lets the kernel move the
+ * pages instead of copying them. Mappings are tracked in a list under
+ * their own lock for leak reports and cleanup, and the page holding a
+ * mapping's header is registered in the page map, so free-time lookups
+ * take constant time however many mappings are live. Over-aligned
+ * requests map the alignment on top and unmap the pages in front of the
+ * header placed before the first aligned payload, so a header need not
+ * start its mapping; the mapping always starts on the header's page.
+ * Blocks sampled by the heap profiler also get a mapping, whatever
+ * their size, and tell their profile bucket when they are released.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <sys/mman.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Sized so the payload stays 16-byte aligned */
+typedef struct mem_mmap_chunk {
+    struct mem_mmap_chunk *prev;
+    struct mem_mmap_chunk *next;
+    size_t length;
+    mem_sample_bucket_t *sample;        /* profile bucket of a sampled block */
+    size_t sample_size;                 /* size the sampled block was asked for */
+    mem_block_t block;
+} mem_mmap_chunk_t;
+
+/* The header and the first payload byte, which may start the next page */
+#define CHUNK_SPAN      (sizeof(mem_mmap_chunk_t) + 1)
+
+static mem_mmap_chunk_t *chunks = NULL;
+static size_t chunk_count = 0;
+static pthread_mutex_t chunks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int track(mem_mmap_chunk_t *chunk)
+{
+    if (mem_page_map_set(chunk, CHUNK_SPAN, MEM_PAGE_MMAP, chunk) != 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&chunks_lock);
+    chunk->prev = NULL;
+    chunk->next = chunks;
+    if (chunks != NULL) {
+        chunks->prev = chunk;
+    }
+    chunks = chunk;
+    __atomic_store_n(&chunk_count, chunk_count + 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&chunks_lock);
+    return 0;
+}
+
+static void untrack(mem_mmap_chunk_t *chunk)
+{
+    mem_page_map_clear(chunk, CHUNK_SPAN);
+    if (chunk->prev != NULL) {
+        chunk->prev->next = chunk->next;
+    } else {
+        chunks = chunk->next;
+    }
+    if (chunk->next != NULL) {
+        chunk->next->prev = chunk->prev;
+    }
+    __atomic_store_n(&chunk_count, chunk_count - 1, __ATOMIC_RELAXED);
+}
+
+static mem_mmap_chunk_t* find_chunk(void *ptr)
+{
+    void *owner;
+    
+    if (mem_page_map_lookup(ptr, &owner) != MEM_PAGE_MMAP
+        || mem_block_to_ptr(&((mem_mmap_chunk_t*)owner)->block) != ptr) {
+        return NULL;
+    }
+    return owner;
+}
+
+/* Looks ptr up and removes it from the list, so only one caller owns it */
+static mem_mmap_chunk_t* claim_chunk(void *ptr)
+{
+    pthread_mutex_lock(&chunks_lock);
+    mem_mmap_chunk_t *chunk = find_chunk(ptr);
+    if (chunk != NULL) {
+        untrack(chunk);
+    }
+    pthread_mutex_unlock(&chunks_lock);
+    
+    return chunk;
+}
+
+static size_t page_size(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* Start of the mapping holding chunk, which is the page of its header */
+static char* mapping_of(mem_mmap_chunk_t *chunk)
+{
+    return (char*)((uintptr_t)chunk & ~(uintptr_t)(page_size() - 1));
+}
+
+static size_t header_offset(mem_mmap_chunk_t *chunk)
+{
+    return (size_t)((char*)chunk - mapping_of(chunk));
+}
+
+static void set_length(mem_mmap_chunk_t *chunk, size_t length)
+{
+    chunk->length = length;
+    chunk->block.header = (length - header_offset(chunk) - sizeof(mem_mmap_chunk_t)) | MEM_BLOCK_MMAPPED;
+}
+
+static void release_chunk(mem_mmap_chunk_t *chunk)
+{
+    if (chunk->sample != NULL) {
+        mem_sample_release(chunk->sample, chunk->sample_size);
+    }
+    mem_stats_record_free(mem_block_size(&chunk->block));
+    munmap(mapping_of(chunk), chunk->length);
+}
+
+/*
+ * Page-rounded mapping length for a block of size bytes whose header
+ * sits offset bytes into the mapping, or 0 if it does not fit in size_t
+ */
+static size_t chunk_length(size_t size, size_t offset)
+{
+    if (size > SIZE_MAX - offset - sizeof(mem_mmap_chunk_t) - page_size()) {
+        return 0;
+    }
+    return mem_page_align(offset + sizeof(mem_mmap_chunk_t) + size);
+}
+
+static void* map_pages(size_t length)
+{
+    void *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    
+    return mapping != MAP_FAILED ? mapping : NULL;
+}
+
+static void* publish_chunk(mem_mmap_chunk_t *chunk, size_t length, mem_sample_bucket_t *sample, size_t sample_size)
+{
+    set_length(chunk, length);
+    chunk->sample = sample;
+    chunk->sample_size = sample_size;
+    if (track(chunk) != 0) {
+        munmap(mapping_of(chunk), length);
+        return NULL;
+    }
+    mem_stats_record_allocation(mem_block_size(&chunk->block));
+    return mem_block_to_ptr(&chunk->block);
+}
+
+static void* map_chunk(size_t size, mem_sample_bucket_t *sample, size_t sample_size)
+{
+    size_t length = chunk_length(size, 0);
+    mem_mmap_chunk_t *chunk = length != 0 ? map_pages(length) : NULL;
+    
+    return chunk != NULL ? publish_chunk(chunk, length, sample, sample_size) : NULL;
+}
+
+void* mem_mmap_alloc(size_t size)
+{
+    return map_chunk(size, NULL, 0);
+}
+
+/* The slack in front of the header's page and past the block's last page is unmapped */
+void* mem_mmap_alloc_aligned(size_t size, size_t alignment)
+{
+    size_t length = size <= SIZE_MAX - alignment ? chunk_length(size + alignment, 0) : 0;
+    char *mapping = length != 0 ? map_pages(length) : NULL;
+    
+    if (mapping == NULL) {
+        return NULL;
+    }
+    
+    uintptr_t first = (uintptr_t)mapping + sizeof(mem_mmap_chunk_t);
+    char *payload = (char*)((first + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    mem_mmap_chunk_t *chunk = (mem_mmap_chunk_t*)(payload - sizeof(mem_mmap_chunk_t));
+    char *start = mapping_of(chunk);
+    char *end = start + chunk_length(size, header_offset(chunk));
+    
+    if (start > mapping) {
+        munmap(mapping, (size_t)(start - mapping));
+    }
+    if (end < mapping + length) {
+        munmap(end, (size_t)(mapping + length - end));
+    }
+    return publish_chunk(chunk, (size_t)(end - start), NULL, 0);
+}
+
+void* mem_mmap_alloc_sampled(size_t size, mem_sample_bucket_t *bucket)
+{
+    return map_chunk(mem_align_size(size), bucket, size);
+}
+
+bool mem_mmap_free(void *ptr)
+{
+    mem_mmap_chunk_t *chunk = claim_chunk(ptr);
+    
+    if (chunk == NULL) {
+        return false;
+    }
+    release_chunk(chunk);
+    return true;
+}
+
+static void* remap_chunk(mem_mmap_chunk_t *chunk, size_t size)
+{
+    size_t old_size = mem_block_size(&chunk->block);
+    size_t offset = header_offset(chunk);
+    size_t length = chunk_length(size, offset);
+    char *mapping = length != 0 ? mremap(mapping_of(chunk), chunk->length, length, MREMAP_MAYMOVE) : MAP_FAILED;
+    
+    if (mapping == MAP_FAILED) {
+        (void)track(chunk);
+        return NULL;
+    }
+    
+    /* The header keeps its offset, so an over-aligned payload may lose its alignment */
+    mem_mmap_chunk_t *moved = (mem_mmap_chunk_t*)(mapping + offset);
+    set_length(moved, length);
+    (void)track(moved);
+    if (mem_block_size(&moved->block) > old_size) {
+        mem_stats_record_growth(mem_block_size(&moved->block) - old_size);
+    } else {
+        mem_stats_record_shrink(old_size - mem_block_size(&moved->block));
+    }
+    return mem_block_to_ptr(&moved->block);
+}
+
+static void* move_to_heap(mem_mmap_chunk_t *chunk, size_t size)
+{
+    void *ptr = mem_malloc(size);
+    
+    if (ptr == NULL) {
+        (void)track(chunk);
+        return NULL;
+    }
+    
+    /* Sampled blocks may be smaller than the request */
+    size_t old_size = mem_block_size(&chunk->block);
+    memcpy(ptr, mem_block_to_ptr(&chunk->block), size < old_size ? size : old_size);
+    release_chunk(chunk);
+    return ptr;
+}
+
+void* mem_mmap_realloc(void *ptr, size_t size)
+{
+    mem_mmap_chunk_t *chunk = claim_chunk(ptr);
+    
+    if (chunk == NULL) {
+        return NULL;
+    }
+    
+    size_t aligned = mem_align_size(size);
+    if (aligned < size) {
+        (void)track(chunk);
+        return NULL;
+    }
+    
+    /* The heap gets the request itself, so a tiny result lands in its class */
+    if (aligned < mem_mmap_threshold) {
+        return move_to_heap(chunk, size);
+    }
+    return remap_chunk(chunk, aligned);
+}
+
+size_t mem_mmap_size(void *ptr)
+{
+    size_t size = 0;
+    
+    pthread_mutex_lock(&chunks_lock);
+    mem_mmap_chunk_t *chunk = find_chunk(ptr);
+    if (chunk != NULL) {
+        size = mem_block_size(&chunk->block);
+    }
+    pthread_mutex_unlock(&chunks_lock);
+    
+    return size;
+}
+
+void mem_mmap_release_all(void)
+{
+    pthread_mutex_lock(&chunks_lock);
+    while (chunks != NULL) {
+        mem_mmap_chunk_t *next = chunks->next;
+        mem_page_map_clear(chunks, CHUNK_SPAN);
+        munmap(mapping_of(chunks), chunks->length);
+        chunks = next;
+    }
+    __atomic_store_n(&chunk_count, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&chunks_lock);
+}
+
+size_t mem_mmap_count(void)
+{
+    return __atomic_load_n(&chunk_count, __ATOMIC_RELAXED);
+}
+
+void mem_mmap_for_each(void (*visit)(mem_block_t *block, void *arg), void *arg)
+{
+    pthread_mutex_lock(&chunks_lock);
+    for (mem_mmap_chunk_t *chunk = chunks; chunk != NULL; chunk = chunk->next) {
+        visit(&chunk->block, arg);
+    }
+    pthread_mutex_unlock(&chunks_lock);
+}
+
+void mem_mmap_lock(void)
+{
+    pthread_mutex_lock(&chunks_lock);
+}
+
+void mem_mmap_unlock(void)
+{
+    pthread_mutex_unlock(&chunks_lock);
+}
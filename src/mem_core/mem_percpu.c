@@ -0,0 +1,290 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Per-CPU Caches
+ * ============================================================================
+ * 
+ * This file implements the optional per-CPU small block caches selected
+ * with MEM_CACHE_PER_CPU. Each CPU owns one array stack per small size
+ * class; pushes and pops commit with a single store inside a Linux
+ * restartable sequence (rseq), so they need neither locks nor atomics
+ * and are restarted by the kernel if the thread is preempted or migrated
+ * halfway. Cached memory therefore scales with the number of CPUs rather
+ * than the number of threads.
+ * 
+ * The critical sections use glibc's rseq registration (glibc 2.35+) and
+ * are written for x86_64. Elsewhere, or when the kernel refused the
+ * registration, mem_percpu_init fails and mem_init keeps per-thread caches.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 35)
+#define MEM_HAVE_RSEQ 1
+#include <sys/rseq.h>
+#endif
+#endif
+
+/* Hand-off through a CPU's stack is ordered by the CPU, not by atomics */
+#ifdef __SANITIZE_THREAD__
+void __tsan_acquire(void *addr);
+void __tsan_release(void *addr);
+#define TSAN_ACQUIRE(addr) __tsan_acquire(addr)
+#define TSAN_RELEASE(addr) __tsan_release(addr)
+#else
+#define TSAN_ACQUIRE(addr) ((void)(addr))
+#define TSAN_RELEASE(addr) ((void)(addr))
+#endif
+
+typedef struct mem_percpu_class {
+    size_t count;
+    void *slots[MEM_PERCPU_CAPACITY];
+} mem_percpu_class_t;
+
+static const size_t cpu_stride = sizeof(mem_percpu_class_t) * MEM_TCACHE_CLASSES;
+static mem_percpu_class_t *cpu_caches = NULL;
+static size_t cpu_count = 0;
+
+#ifdef MEM_HAVE_RSEQ
+
+/* Descriptor for [1, 2) aborting to 4, which re-arms at 0 */
+#define RSEQ_SECTION_BEGIN                                      \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                        \
+    ".balign 32\n\t"                                            \
+    "3:\n\t"                                                    \
+    ".long 0, 0\n\t"                                            \
+    ".quad 1f, 2f - 1f, 4f\n\t"                                 \
+    ".popsection\n\t"                                           \
+    "0:\n\t"                                                    \
+    "leaq 3b(%%rip), %[slot]\n\t"                               \
+    "movq %[slot], %c[cs](%[rseq])\n\t"                         \
+    "1:\n\t"                                                    \
+    "movl %c[cpu](%[rseq]), %k[slot]\n\t"                       \
+    "cmpq %[cpus], %[slot]\n\t"                                 \
+    "jae 5f\n\t"                                                \
+    "imulq %[stride], %[slot]\n\t"                              \
+    "addq %[classes], %[slot]\n\t"                              \
+    "movq (%[slot]), %[count]\n\t"
+
+#define RSEQ_SECTION_ABORT                                      \
+    ".pushsection __rseq_failure, \"ax\"\n\t"                   \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                                \
+    ".long 0x53053053\n\t"                                      \
+    "4:\n\t"                                                    \
+    "jmp 0b\n\t"                                                \
+    ".popsection\n\t"
+
+#define RSEQ_SECTION_INPUTS(base)                               \
+    [rseq] "r" (thread_rseq()), [classes] "r" (base),           \
+    [cpus] "r" (cpu_count), [stride] "r" (cpu_stride),          \
+    [cs] "i" (offsetof(struct rseq, rseq_cs)),                  \
+    [cpu] "i" (offsetof(struct rseq, cpu_id))
+
+static struct rseq* thread_rseq(void)
+{
+    return (struct rseq*)((char*)__builtin_thread_pointer() + __rseq_offset);
+}
+
+static bool rseq_available(void)
+{
+    return __rseq_size > 0 && (int32_t)thread_rseq()->cpu_id >= 0;
+}
+
+static void* percpu_pop(size_t index)
+{
+    uintptr_t slot, count;
+    void *item;
+    
+    TSAN_ACQUIRE(cpu_caches + index);
+    __asm__ __volatile__(
+        RSEQ_SECTION_BEGIN
+        "testq %[count], %[count]\n\t"
+        "jz 5f\n\t"
+        "movq (%[slot], %[count], 8), %[item]\n\t"
+        "decq %[count]\n\t"
+        "movq %[count], (%[slot])\n\t"
+        "2:\n\t"
+        "jmp 6f\n\t"
+        RSEQ_SECTION_ABORT
+        "5:\n\t"
+        "xorl %k[item], %k[item]\n\t"
+        "6:\n\t"
+        : [item] "=&r" (item), [slot] "=&r" (slot), [count] "=&r" (count)
+        : RSEQ_SECTION_INPUTS(cpu_caches + index)
+        : "memory", "cc");
+    TSAN_ACQUIRE(cpu_caches + index);
+    return item;
+}
+
+static bool percpu_push(size_t index, void *item)
+{
+    uintptr_t slot, count, pushed;
+    
+    TSAN_RELEASE(cpu_caches + index);
+    __asm__ __volatile__(
+        RSEQ_SECTION_BEGIN
+        "cmpq %[capacity], %[count]\n\t"
+        "jae 5f\n\t"
+        "movq %[item], 8(%[slot], %[count], 8)\n\t"
+        "incq %[count]\n\t"
+        "movq %[count], (%[slot])\n\t"
+        "2:\n\t"
+        "movl $1, %k[pushed]\n\t"
+        "jmp 6f\n\t"
+        RSEQ_SECTION_ABORT
+        "5:\n\t"
+        "xorl %k[pushed], %k[pushed]\n\t"
+        "6:\n\t"
+        : [pushed] "=&r" (pushed), [slot] "=&r" (slot), [count] "=&r" (count)
+        : [item] "r" (item), [capacity] "i" (MEM_PERCPU_CAPACITY),
+          RSEQ_SECTION_INPUTS(cpu_caches + index)
+        : "memory", "cc");
+    return pushed != 0;
+}
+
+#else
+
+static bool rseq_available(void)
+{
+    return false;
+}
+
+static void* percpu_pop(size_t index)
+{
+    (void)index;
+    return NULL;
+}
+
+static bool percpu_push(size_t index, void *item)
+{
+    (void)index;
+    (void)item;
+    return false;
+}
+
+#endif /* MEM_HAVE_RSEQ */
+
+static size_t class_of(size_t size)
+{
+    return (size - MEM_MIN_BLOCK_SIZE) / MEM_ALIGNMENT;
+}
+
+static void release_entry(mem_tcache_entry_t *entry)
+{
+    entry->next = NULL;
+    mem_tcache_release_list(entry);
+}
+
+static void stash(size_t index, mem_tcache_entry_t *entry)
+{
+    entry->key = mem_tcache_key;
+    if (!percpu_push(index, entry)) {
+        release_entry(entry);
+    }
+}
+
+static void* refill(size_t index, size_t size)
+{
+    mem_heap_t *heap = mem_thread_heap();
+    void *objects[MEM_TCACHE_BATCH];
+    size_t filled;
+    
+    if (heap == NULL) {
+        return NULL;
+    }
+    
+    filled = mem_heap_allocate_batch(heap, size, objects, MEM_TCACHE_BATCH);
+    for (size_t i = filled; i > 1; i--) {
+        stash(index, objects[i - 1]);
+    }
+    return filled > 0 ? objects[0] : NULL;
+}
+
+static void flush_class(size_t index, size_t limit)
+{
+    mem_tcache_entry_t *list = NULL;
+    mem_tcache_entry_t *entry;
+    
+    for (size_t i = 0; i < limit && (entry = percpu_pop(index)) != NULL; i++) {
+        entry->next = list;
+        list = entry;
+    }
+    mem_tcache_release_list(list);
+}
+
+int mem_percpu_init(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    void *caches;
+    
+    if (!rseq_available() || cpus <= 0 || cpus > MEM_PERCPU_MAX_CPUS) {
+        return -1;
+    }
+    
+    caches = mmap(NULL, (size_t)cpus * cpu_stride, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (caches == MAP_FAILED) {
+        return -1;
+    }
+    
+    cpu_caches = caches;
+    cpu_count = (size_t)cpus;
+    return 0;
+}
+
+void mem_percpu_destroy(void)
+{
+    if (cpu_caches != NULL) {
+        munmap(cpu_caches, cpu_count * cpu_stride);
+    }
+    cpu_caches = NULL;
+    cpu_count = 0;
+}
+
+void* mem_percpu_alloc(size_t size)
+{
+    size_t index = class_of(size);
+    mem_tcache_entry_t *entry = percpu_pop(index);
+    
+    if (entry == NULL) {
+        entry = refill(index, size);
+    }
+    if (entry != NULL) {
+        entry->key = 0;
+    }
+    return entry;
+}
+
+bool mem_percpu_free(mem_block_t *block, size_t size)
+{
+    mem_tcache_entry_t *entry = mem_block_to_ptr(block);
+    size_t index = class_of(size);
+    
+    if (cpu_caches == NULL || size >= MEM_SMALL_BIN_LIMIT) {
+        return false;
+    }
+    
+    entry->key = mem_tcache_key;
+    if (!percpu_push(index, entry)) {
+        flush_class(index, MEM_TCACHE_BATCH);
+        stash(index, entry);
+    }
+    return true;
+}
+
+void mem_percpu_flush(void)
+{
+    for (size_t i = 0; i < MEM_TCACHE_CLASSES; i++) {
+        flush_class(i, MEM_PERCPU_CAPACITY);
+    }
+}
+
+mem_cache_mode_t mem_get_cache_mode(void)
+{
+    return mem_cache_mode;
+}
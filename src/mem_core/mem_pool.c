@@ -0,0 +1,368 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Object Pools
+ * ============================================================================
+ * 
+ * This file implements fixed-size object pools. A pool hands out objects
+ * from slabs that are aligned to their own power-of-two size, so the
+ * slab header is found by masking an object's address and objects carry
+ * no header of their own. Each slab keeps an intrusive free list of
+ * returned objects and carves never-used ones lazily, so alloc and free
+ * are O(1) and untouched slab pages stay clean. Slabs with free objects
+ * sit on the pool's partial list, full slabs on its full list, and an
+ * empty slab is given back unless it is the last partial one. Slabs are
+ * aligned heap blocks one header short of the slab size, so consecutive
+ * slabs tile the heap without gaps. Each pool has its own lock. A freed
+ * pointer is only trusted once its heap vouches for the masked base as
+ * a live block, the slab names the pool, and the slab's bitmap shows the
+ * slot in use, so stray pointers and double frees are ignored.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <string.h>
+#include <unistd.h>
+
+typedef struct mem_pool_slab {
+    struct mem_pool_slab *prev;
+    struct mem_pool_slab *next;
+    mem_pool_t *pool;
+    void *free_list;
+    size_t in_use;
+    size_t carved;
+    uint64_t in_use_map[];              /* one bit per slot handed out */
+} mem_pool_slab_t;
+
+struct mem_pool {
+    pthread_mutex_t lock;
+    size_t stride;
+    size_t slab_header;
+    size_t slab_size;
+    size_t per_slab;
+    size_t map_words;
+    mem_pool_slab_t *partial;
+    mem_pool_slab_t *full;
+    size_t slab_count;
+    size_t in_use;
+    struct mem_pool *prev_pool;
+    struct mem_pool *next_pool;
+};
+
+static mem_pool_t *pools = NULL;
+static pthread_mutex_t pools_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t round_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static void link_slab(mem_pool_slab_t **list, mem_pool_slab_t *slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list != NULL) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+static void unlink_slab(mem_pool_slab_t **list, mem_pool_slab_t *slab)
+{
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+/* ========================================================================== */
+/* POOL REGISTRY */
+/* ========================================================================== */
+
+static void register_pool(mem_pool_t *pool)
+{
+    pthread_mutex_lock(&pools_lock);
+    pool->prev_pool = NULL;
+    pool->next_pool = pools;
+    if (pools != NULL) {
+        pools->prev_pool = pool;
+    }
+    pools = pool;
+    pthread_mutex_unlock(&pools_lock);
+}
+
+static void unregister_pool(mem_pool_t *pool)
+{
+    pthread_mutex_lock(&pools_lock);
+    if (pool->prev_pool != NULL) {
+        pool->prev_pool->next_pool = pool->next_pool;
+    } else {
+        pools = pool->next_pool;
+    }
+    if (pool->next_pool != NULL) {
+        pool->next_pool->prev_pool = pool->prev_pool;
+    }
+    pthread_mutex_unlock(&pools_lock);
+}
+
+void mem_pool_for_each(void (*visit)(mem_pool_t *pool, void *arg), void *arg)
+{
+    pthread_mutex_lock(&pools_lock);
+    for (mem_pool_t *pool = pools; pool != NULL; pool = pool->next_pool) {
+        visit(pool, arg);
+    }
+    pthread_mutex_unlock(&pools_lock);
+}
+
+/* Pools live in the heaps, so mem_cleanup only has to drop the list */
+void mem_pool_forget_all(void)
+{
+    pthread_mutex_lock(&pools_lock);
+    pools = NULL;
+    pthread_mutex_unlock(&pools_lock);
+}
+
+/* ========================================================================== */
+/* SLABS */
+/* ========================================================================== */
+
+static mem_pool_slab_t* add_slab(mem_pool_t *pool)
+{
+    mem_pool_slab_t *slab = mem_aligned_alloc(pool->slab_size, pool->slab_size - MEM_HEADER_SIZE);
+    
+    if (slab == NULL) {
+        return NULL;
+    }
+    
+    slab->pool = pool;
+    slab->free_list = NULL;
+    slab->in_use = 0;
+    slab->carved = 0;
+    memset(slab->in_use_map, 0, pool->map_words * sizeof(uint64_t));
+    link_slab(&pool->partial, slab);
+    pool->slab_count++;
+    return slab;
+}
+
+static size_t slot_of(mem_pool_t *pool, mem_pool_slab_t *slab, void *object)
+{
+    return (size_t)((char*)object - (char*)slab - pool->slab_header) / pool->stride;
+}
+
+/* Slabs leave the pool unnamed, so a stale pointer into one is not taken for ours */
+static void release_slab(mem_pool_slab_t *slab)
+{
+    slab->pool = NULL;
+    mem_free(slab);
+}
+
+static void* take_object(mem_pool_t *pool, mem_pool_slab_t *slab)
+{
+    void *object = slab->free_list;
+    
+    if (object != NULL) {
+        slab->free_list = *(void**)object;
+    } else {
+        object = (char*)slab + pool->slab_header + slab->carved++ * pool->stride;
+    }
+    
+    size_t slot = slot_of(pool, slab, object);
+    slab->in_use_map[slot / 64] |= (uint64_t)1 << (slot % 64);
+    
+    if (++slab->in_use == pool->per_slab) {
+        unlink_slab(&pool->partial, slab);
+        link_slab(&pool->full, slab);
+    }
+    pool->in_use++;
+    return object;
+}
+
+static void put_object(mem_pool_t *pool, mem_pool_slab_t *slab, void *object, size_t slot)
+{
+    slab->in_use_map[slot / 64] &= ~((uint64_t)1 << (slot % 64));
+    if (slab->in_use-- == pool->per_slab) {
+        unlink_slab(&pool->full, slab);
+        link_slab(&pool->partial, slab);
+    }
+    *(void**)object = slab->free_list;
+    slab->free_list = object;
+    pool->in_use--;
+    
+    if (slab->in_use == 0 && (slab->prev != NULL || slab->next != NULL)) {
+        unlink_slab(&pool->partial, slab);
+        pool->slab_count--;
+        release_slab(slab);
+    }
+}
+
+/* The masked base is only read once its heap vouches for a live block that size */
+static mem_pool_slab_t* find_slab(mem_pool_t *pool, void *ptr)
+{
+    mem_pool_slab_t *slab = (mem_pool_slab_t*)((uintptr_t)ptr & ~(uintptr_t)(pool->slab_size - 1));
+    mem_heap_t *heap = mem_heap_of(slab);
+    
+    if (heap == NULL || !mem_is_valid_ptr(heap, slab)) {
+        return NULL;
+    }
+    
+    mem_block_t *block = mem_ptr_to_block(slab);
+    if (mem_block_is_free(block) || mem_block_size(block) < pool->slab_size - MEM_HEADER_SIZE) {
+        return NULL;
+    }
+    return slab;
+}
+
+/* Returns the slot of a live object of the slab, or per_slab */
+static size_t object_slot(mem_pool_t *pool, mem_pool_slab_t *slab, void *ptr)
+{
+    size_t offset = (size_t)((char*)ptr - (char*)slab);
+    
+    if (slab->pool != pool || offset < pool->slab_header) {
+        return pool->per_slab;
+    }
+    
+    size_t slot = slot_of(pool, slab, ptr);
+    if (slot * pool->stride != offset - pool->slab_header || slot >= slab->carved
+        || !((slab->in_use_map[slot / 64] >> (slot % 64)) & 1)) {
+        return pool->per_slab;
+    }
+    return slot;
+}
+
+static void free_slabs(mem_pool_slab_t *slab)
+{
+    while (slab != NULL) {
+        mem_pool_slab_t *next = slab->next;
+        release_slab(slab);
+        slab = next;
+    }
+}
+
+/* ========================================================================== */
+/* PUBLIC INTERFACE */
+/* ========================================================================== */
+
+static size_t slab_header_size(size_t per_slab, size_t alignment)
+{
+    return round_up(sizeof(mem_pool_slab_t) + (per_slab + 63) / 64 * sizeof(uint64_t), alignment);
+}
+
+/* The bitmap grows with the slot count, so slots are given up until the header fits */
+static size_t slots_per_slab(size_t usable, size_t stride, size_t alignment)
+{
+    if (slab_header_size(0, alignment) >= usable) {
+        return 0;
+    }
+    
+    size_t per_slab = (usable - slab_header_size(0, alignment)) / stride;
+    
+    while (per_slab > 0 && slab_header_size(per_slab, alignment) + per_slab * stride > usable) {
+        per_slab--;
+    }
+    return per_slab;
+}
+
+static bool configure_pool(mem_pool_t *pool, size_t object_size, size_t alignment)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    
+    alignment = alignment > sizeof(void*) ? alignment : sizeof(void*);
+    pool->stride = round_up(object_size > sizeof(void*) ? object_size : sizeof(void*), alignment);
+    pool->slab_size = page;
+    while (pool->slab_size <= MEM_POOL_MAX_SLAB
+           && slots_per_slab(pool->slab_size - MEM_HEADER_SIZE, pool->stride, alignment) < MEM_POOL_MIN_OBJECTS) {
+        pool->slab_size *= 2;
+    }
+    if (pool->slab_size > MEM_POOL_MAX_SLAB) {
+        return false;
+    }
+    
+    pool->per_slab = slots_per_slab(pool->slab_size - MEM_HEADER_SIZE, pool->stride, alignment);
+    pool->slab_header = slab_header_size(pool->per_slab, alignment);
+    pool->map_words = (pool->per_slab + 63) / 64;
+    return true;
+}
+
+/* Objects are aligned within their slab, so a slab must hold several aligned strides */
+mem_pool_t* mem_pool_create(size_t object_size, size_t alignment)
+{
+    if (object_size == 0 || object_size > MEM_POOL_MAX_SLAB || (alignment & (alignment - 1)) != 0
+        || alignment > MEM_POOL_MAX_SLAB / MEM_POOL_MIN_OBJECTS) {
+        return NULL;
+    }
+    
+    mem_pool_t *pool = mem_calloc(1, sizeof(mem_pool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (!configure_pool(pool, object_size, alignment)) {
+        mem_free(pool);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&pool->lock, NULL);
+    register_pool(pool);
+    return pool;
+}
+
+void mem_pool_destroy(mem_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    
+    unregister_pool(pool);
+    free_slabs(pool->partial);
+    free_slabs(pool->full);
+    pthread_mutex_destroy(&pool->lock);
+    mem_free(pool);
+}
+
+void* mem_pool_alloc(mem_pool_t *pool)
+{
+    void *object = NULL;
+    
+    pthread_mutex_lock(&pool->lock);
+    mem_pool_slab_t *slab = pool->partial != NULL ? pool->partial : add_slab(pool);
+    if (slab != NULL) {
+        object = take_object(pool, slab);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return object;
+}
+
+void mem_pool_free(mem_pool_t *pool, void *ptr)
+{
+    if (pool == NULL || ptr == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    mem_pool_slab_t *slab = find_slab(pool, ptr);
+    size_t slot = slab != NULL ? object_slot(pool, slab, ptr) : pool->per_slab;
+    if (slot != pool->per_slab) {
+        put_object(pool, slab, ptr, slot);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void mem_pool_get_stats(mem_pool_t *pool, mem_pool_stats_t *stats)
+{
+    if (pool == NULL || stats == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    stats->object_size = pool->stride;
+    stats->objects_in_use = pool->in_use;
+    stats->objects_free = pool->slab_count * pool->per_slab - pool->in_use;
+    stats->slab_count = pool->slab_count;
+    stats->slab_bytes = pool->slab_count * pool->slab_size;
+    pthread_mutex_unlock(&pool->lock);
+}
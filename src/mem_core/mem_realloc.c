@@ -4,7 +4,14 @@
  * ============================================================================
  * 
  * This file implements the mem_realloc function with size validation,
- * block resizing, and memory copying when needed.
+ * block resizing, and memory copying when needed. In-place work happens
+ * under the owning heap's lock: a block grows by taking the front of a
+ * free successor, committing more of the heap first when it borders the
+ * top, and a shrunk block's tail merges with a free successor. Only when
+ * that fails, or the new size reaches the mmap threshold, does the block
+ * move through mem_malloc and mem_free. Large mappings are resized with
+ * mremap instead, and tiny objects stay put while the new size keeps
+ * their class.
  * 
  * ============================================================================
  */
@@ -13,26 +20,94 @@
 #include "../../include/mem_utils.h"
 #include <string.h>
 
-static void* handle_size_decrease(mem_block_t *block, size_t new_size, size_t old_size)
+static void* handle_size_decrease(mem_heap_t *heap, mem_block_t *block,
+                                  size_t new_size, size_t old_size)
 {
-    if (old_size - new_size >= sizeof(mem_block_t) + MEM_MIN_BLOCK_SIZE) {
-        mem_split_block(block, new_size);
+    mem_block_t *tail = mem_split_block(heap, block, new_size);
+    
+    if (tail != NULL) {
+        mem_bin_remove(heap, tail);
+        mem_merge_blocks(heap, tail);
+        mem_stats_record_shrink(old_size - new_size);
     }
     return mem_block_to_ptr(block);
 }
 
-static void* handle_size_increase(void *ptr, size_t new_size, size_t old_size)
+/* The rest of a clean successor only covers bytes that were zero, so it stays clean */
+static bool extend_into_next(mem_heap_t *heap, mem_block_t *block, size_t new_size)
+{
+    mem_block_t *next = mem_block_successor(block);
+    size_t old_size = mem_block_size(block);
+    
+    if (!mem_block_is_free(next) || old_size + MEM_HEADER_SIZE + mem_block_size(next) < new_size) {
+        return false;
+    }
+    
+    uint64_t since = mem_block_dirty_since(next);
+    mem_bin_remove(heap, next);
+    mem_block_set_size(block, old_size + MEM_HEADER_SIZE + mem_block_size(next));
+    mem_block_mark_used(block);
+    heap->num_blocks--;
+    
+    mem_block_t *rest = mem_split_block(heap, block, new_size);
+    if (rest != NULL) {
+        mem_bin_remove(heap, rest);
+        mem_block_set_dirty_since(rest, since);
+        mem_bin_insert(heap, rest);
+    }
+    mem_stats_record_growth(mem_block_size(block) - old_size);
+    return true;
+}
+
+static bool borders_top(mem_block_t *block)
+{
+    mem_block_t *next = mem_block_successor(block);
+    
+    if (mem_block_is_free(next)) {
+        next = mem_block_successor(next);
+    }
+    return mem_block_size(next) == 0;
+}
+
+static bool grow_in_place(mem_heap_t *heap, mem_block_t *block, size_t new_size)
+{
+    if (new_size >= mem_mmap_threshold) {
+        return false;
+    }
+    if (extend_into_next(heap, block, new_size)) {
+        return true;
+    }
+    return borders_top(block)
+        && mem_heap_grow(heap, new_size - mem_block_size(block)) == 0
+        && extend_into_next(heap, block, new_size);
+}
+
+static void* move_block(void *ptr, size_t new_size, size_t copy_size)
 {
     void *new_ptr = mem_malloc(new_size);
     if (new_ptr == NULL) {
         return NULL;
     }
     
-    memcpy(new_ptr, ptr, old_size);
+    memcpy(new_ptr, ptr, copy_size);
     mem_free(ptr);
     return new_ptr;
 }
 
+static void* realloc_tiny(void *ptr, size_t new_size)
+{
+    size_t old_size = mem_tiny_size(ptr);
+    
+    if (old_size == 0) {
+        return NULL;
+    }
+    /* Stay put only within the class, so sized frees keep naming the right one */
+    if (new_size <= old_size && new_size > old_size - MEM_ALIGNMENT) {
+        return ptr;
+    }
+    return move_block(ptr, new_size, new_size < old_size ? new_size : old_size);
+}
+
 void* mem_realloc(void *ptr, size_t new_size)
 {
     if (ptr == NULL) {
@@ -43,18 +118,41 @@ void* mem_realloc(void *ptr, size_t new_size)
         mem_free(ptr);
         return NULL;
     }
+    /* No object may exceed PTRDIFF_MAX, and aligning a larger size would wrap */
+    if (new_size > PTRDIFF_MAX) {
+        return NULL;
+    }
+    
+    if (mem_tiny_owns(ptr)) {
+        return realloc_tiny(ptr, new_size);
+    }
     
-    if (!mem_is_valid_ptr(ptr)) {
+    mem_heap_t *heap = mem_heap_of(ptr);
+    if (heap == NULL) {
+        return mem_mmap_realloc(ptr, new_size);
+    }
+    
+    pthread_mutex_lock(&heap->lock);
+    if (!mem_is_valid_ptr(heap, ptr) || mem_block_is_free(mem_ptr_to_block(ptr))) {
+        pthread_mutex_unlock(&heap->lock);
         return NULL;
     }
     
     mem_block_t *block = mem_ptr_to_block(ptr);
-    size_t old_size = block->size;
+    size_t old_size = mem_block_size(block);
     new_size = mem_align_size(new_size);
     
     if (new_size <= old_size) {
-        return handle_size_decrease(block, new_size, old_size);
+        void *result = handle_size_decrease(heap, block, new_size, old_size);
+        pthread_mutex_unlock(&heap->lock);
+        return result;
+    }
+    
+    bool grown = grow_in_place(heap, block, new_size);
+    pthread_mutex_unlock(&heap->lock);
+    if (grown) {
+        return ptr;
     }
     
-    return handle_size_increase(ptr, new_size, old_size);
+    return move_block(ptr, new_size, old_size);
 }
@@ -0,0 +1,49 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Remote Frees
+ * ============================================================================
+ * 
+ * This file implements the per-heap remote free stacks. A thread freeing
+ * a block owned by a heap it is not bound to pushes the block with a
+ * single compare-and-swap instead of taking the owner's lock. Whoever
+ * next allocates from that heap detaches the whole stack under the heap
+ * lock and merges the blocks back in one batch.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+void mem_remote_free_push(mem_heap_t *heap, mem_block_t *block)
+{
+    mem_tcache_entry_t *entry = mem_block_to_ptr(block);
+    mem_tcache_entry_t *head = __atomic_load_n(&heap->remote_frees, __ATOMIC_RELAXED);
+    
+    entry->key = mem_tcache_key;
+    do {
+        entry->next = head;
+    } while (!__atomic_compare_exchange_n(&heap->remote_frees, &head, entry, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+size_t mem_remote_free_drain(mem_heap_t *heap)
+{
+    mem_tcache_entry_t *entry;
+    size_t drained = 0;
+    
+    if (__atomic_load_n(&heap->remote_frees, __ATOMIC_RELAXED) == NULL) {
+        return 0;
+    }
+    
+    entry = __atomic_exchange_n(&heap->remote_frees, NULL, __ATOMIC_ACQUIRE);
+    while (entry != NULL) {
+        mem_tcache_entry_t *next = entry->next;
+        
+        entry->key = 0;
+        mem_heap_release(heap, mem_ptr_to_block(entry));
+        entry = next;
+        drained++;
+    }
+    return drained;
+}
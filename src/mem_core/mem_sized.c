@@ -0,0 +1,122 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Sized Deallocation
+ * ============================================================================
+ * 
+ * This file implements mem_free_sized and mem_realloc_sized for callers
+ * that know the size they asked for, such as C++ sized delete. One page
+ * map lookup routes the pointer. Tiny objects take their class straight
+ * from the size, skipping the bitmap check and the magazine scan; the
+ * run header still has to agree, since a block may come from a larger
+ * class than the size implies, and anything else goes to mem_free. Heap
+ * blocks skip the pointer validation and the double-free scan of the
+ * thread cache; their header word, next to the cache link written anyway,
+ * still provides the exact size for the statistics. A size of zero means
+ * unknown and falls back to mem_free. DEBUG builds cross-check the size
+ * against the block and fall back to mem_free on a mismatch.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <stdio.h>
+#include <string.h>
+
+static size_t tiny_class_of(size_t size)
+{
+    return (size - 1) / MEM_ALIGNMENT;
+}
+
+#ifdef DEBUG
+static bool size_matches(mem_page_kind_t kind, mem_heap_t *heap, void *ptr, size_t size)
+{
+    if (kind == MEM_PAGE_TINY) {
+        return size <= MEM_TINY_MAX && mem_tiny_size(ptr) >= size;
+    }
+    if (kind == MEM_PAGE_MMAP) {
+        return mem_mmap_size(ptr) >= size;
+    }
+    if (!mem_is_valid_ptr(heap, ptr) || mem_block_is_free(mem_ptr_to_block(ptr))) {
+        return false;
+    }
+    
+    /* Blocks keep less than one splittable remainder past the aligned size */
+    size_t block_size = mem_block_size(mem_ptr_to_block(ptr));
+    size_t aligned = mem_align_size(size);
+    return block_size >= aligned && block_size < aligned + MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE;
+}
+
+static bool checked_size(mem_page_kind_t kind, mem_heap_t *heap, void *ptr, size_t size)
+{
+    if (size_matches(kind, heap, ptr, size)) {
+        return true;
+    }
+    fprintf(stderr, "mem_free_sized: %zu bytes does not match the block at %p\n", size, ptr);
+    return false;
+}
+#endif
+
+static void free_heap_block(mem_heap_t *heap, void *ptr)
+{
+    mem_block_t *block = mem_ptr_to_block(ptr);
+    size_t size = __atomic_load_n(&block->header, __ATOMIC_RELAXED) & ~MEM_BLOCK_FLAGS;
+    
+    mem_heap_free_block(heap, block, size, heap != mem_thread_heap());
+}
+
+void mem_free_sized(void *ptr, size_t size)
+{
+    void *owner = NULL;
+    
+    if (ptr == NULL) {
+        return;
+    }
+    
+    mem_page_kind_t kind = mem_page_map_lookup(ptr, &owner);
+    if (size == 0 || kind == MEM_PAGE_NONE || (kind == MEM_PAGE_TINY && size > MEM_TINY_MAX)) {
+        mem_free(ptr);
+        return;
+    }
+#ifdef DEBUG
+    if (!checked_size(kind, owner, ptr, size)) {
+        mem_free(ptr);
+        return;
+    }
+#endif
+    
+    if (kind == MEM_PAGE_TINY) {
+        if (!mem_tiny_free_class(ptr, tiny_class_of(size))) {
+            mem_free(ptr);
+            return;
+        }
+    } else if (kind == MEM_PAGE_HEAP) {
+        free_heap_block(owner, ptr);
+    } else {
+        mem_mmap_free(ptr);
+    }
+}
+
+void* mem_realloc_sized(void *ptr, size_t old_size, size_t new_size)
+{
+    if (ptr == NULL || old_size == 0 || old_size > MEM_TINY_MAX || !mem_tiny_owns(ptr)) {
+        return mem_realloc(ptr, new_size);
+    }
+    if (new_size == 0) {
+        mem_free_sized(ptr, old_size);
+        return NULL;
+    }
+    
+    /* Same class: nothing to do, and no need to look at the run */
+    if (new_size <= MEM_TINY_MAX && tiny_class_of(new_size) == tiny_class_of(old_size)) {
+        return ptr;
+    }
+    
+    void *new_ptr = mem_malloc(new_size);
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, new_size < old_size ? new_size : old_size);
+    mem_free_sized(ptr, old_size);
+    return new_ptr;
+}
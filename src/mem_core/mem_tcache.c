@@ -0,0 +1,216 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Thread Caches
+ * ============================================================================
+ * 
+ * This file implements the per-thread small block caches. A malloc/free
+ * pair of a small size is served from a thread-local LIFO list without
+ * touching any heap lock. Empty lists are refilled with MEM_TCACHE_BATCH
+ * blocks under a single lock acquisition, full lists hand their colder
+ * half back to the owning heaps, and a TLS destructor drains everything
+ * when the thread exits. The length of each list is kept as the counts
+ * of blocks handed out and taken back in the thread's statistics block,
+ * which the statistics read as the small-block totals.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <string.h>
+
+typedef struct mem_tcache {
+    mem_tcache_entry_t *entries[MEM_TCACHE_CLASSES];
+    unsigned generation;
+    bool registered;
+} mem_tcache_t;
+
+static __thread mem_tcache_t thread_cache;
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+static void thread_cache_destructor(void *arg)
+{
+    (void)arg;
+    mem_flush_thread_cache();
+    thread_cache.registered = false;
+}
+
+static void create_cache_key(void)
+{
+    pthread_key_create(&cache_key, thread_cache_destructor);
+}
+
+static mem_tcache_t* current_cache(void)
+{
+    mem_tcache_t *cache = &thread_cache;
+    unsigned generation = __atomic_load_n(&mem_generation, __ATOMIC_ACQUIRE);
+    
+    if (cache->generation != generation) {
+        memset(cache->entries, 0, sizeof(cache->entries));
+        mem_stats_restart_cache(mem_thread_stats.tcache, MEM_TCACHE_CLASSES, &mem_thread_stats.tcache_generation);
+        cache->generation = generation;
+    }
+    
+    if (!cache->registered) {
+        pthread_once(&cache_key_once, create_cache_key);
+        pthread_setspecific(cache_key, cache);
+        cache->registered = true;
+    }
+    return cache;
+}
+
+static size_t class_of(size_t size)
+{
+    return (size - MEM_MIN_BLOCK_SIZE) / MEM_ALIGNMENT;
+}
+
+static mem_cache_counts_t* class_counts(size_t index)
+{
+    return &mem_stats_current()->tcache[index];
+}
+
+static void push_entry(mem_tcache_t *cache, size_t index, void *ptr)
+{
+    mem_tcache_entry_t *entry = ptr;
+    
+    entry->next = cache->entries[index];
+    entry->key = mem_tcache_key;
+    cache->entries[index] = entry;
+}
+
+/*
+ * Every list holds blocks of exactly its class size, since the
+ * statistics price its counts by that size. The last block of a carved
+ * row may keep the row's leftover; it goes to the list of its own size,
+ * or back to the heap past the last list.
+ */
+static void stash_carved(mem_tcache_t *cache, mem_heap_t *heap, void *ptr)
+{
+    mem_block_t *block = mem_ptr_to_block(ptr);
+    size_t size = mem_block_size(block);
+    
+    if (size >= MEM_SMALL_BIN_LIMIT) {
+        pthread_mutex_lock(&heap->lock);
+        mem_heap_release(heap, block);
+        pthread_mutex_unlock(&heap->lock);
+        return;
+    }
+    push_entry(cache, class_of(size), ptr);
+    class_counts(class_of(size))->spare++;
+}
+
+static bool refill(mem_tcache_t *cache, size_t index, size_t size)
+{
+    mem_heap_t *heap = mem_thread_heap();
+    void *objects[MEM_TCACHE_BATCH];
+    size_t filled;
+    
+    if (heap == NULL) {
+        return false;
+    }
+    
+    filled = mem_heap_allocate_batch(heap, size, objects, MEM_TCACHE_BATCH);
+    for (size_t i = filled; i > 0; i--) {
+        stash_carved(cache, heap, objects[i - 1]);
+    }
+    mem_stats_publish_caches();
+    return cache->entries[index] != NULL;
+}
+
+void* mem_tcache_alloc(size_t size)
+{
+    mem_tcache_t *cache = current_cache();
+    size_t index = class_of(size);
+    
+    if (cache->entries[index] == NULL && !refill(cache, index, size)) {
+        return NULL;
+    }
+    
+    mem_tcache_entry_t *entry = cache->entries[index];
+    cache->entries[index] = entry->next;
+    mem_stats_bump(&class_counts(index)->allocs, 1);
+    entry->key = 0;
+    
+    return entry;
+}
+
+void mem_tcache_release_list(mem_tcache_entry_t *entry)
+{
+    mem_heap_t *locked = NULL;
+    
+    while (entry != NULL) {
+        mem_tcache_entry_t *next = entry->next;
+        mem_heap_t *heap = mem_heap_of(entry);
+        
+        if (heap != locked) {
+            if (locked != NULL) {
+                pthread_mutex_unlock(&locked->lock);
+            }
+            pthread_mutex_lock(&heap->lock);
+            locked = heap;
+        }
+        entry->key = 0;
+        mem_heap_release(heap, mem_ptr_to_block(entry));
+        entry = next;
+    }
+    
+    if (locked != NULL) {
+        pthread_mutex_unlock(&locked->lock);
+    }
+}
+
+static void flush_cold_half(mem_tcache_t *cache, mem_cache_counts_t *counts, size_t index)
+{
+    mem_tcache_entry_t *last_kept = cache->entries[index];
+    
+    for (size_t i = 1; i < MEM_TCACHE_BATCH; i++) {
+        last_kept = last_kept->next;
+    }
+    
+    mem_tcache_release_list(last_kept->next);
+    last_kept->next = NULL;
+    counts->spare -= mem_cache_fill(counts) - MEM_TCACHE_BATCH;
+}
+
+bool mem_tcache_free(mem_block_t *block, size_t size)
+{
+    if (size >= MEM_SMALL_BIN_LIMIT) {
+        return false;
+    }
+    
+    mem_tcache_t *cache = current_cache();
+    size_t index = class_of(size);
+    mem_cache_counts_t *counts = class_counts(index);
+    
+    if (mem_cache_fill(counts) >= MEM_TCACHE_CAPACITY) {
+        flush_cold_half(cache, counts, index);
+    }
+    push_entry(cache, index, mem_block_to_ptr(block));
+    mem_stats_bump(&counts->frees, 1);
+    return true;
+}
+
+bool mem_tcache_is_cached(mem_block_t *block)
+{
+    return ((mem_tcache_entry_t*)mem_block_to_ptr(block))->key == mem_tcache_key;
+}
+
+void mem_flush_thread_cache(void)
+{
+    mem_tiny_flush();
+    if (mem_cache_mode == MEM_CACHE_PER_CPU) {
+        mem_percpu_flush();
+        return;
+    }
+    
+    mem_tcache_t *cache = current_cache();
+    
+    for (size_t i = 0; i < MEM_TCACHE_CLASSES; i++) {
+        mem_tcache_release_list(cache->entries[i]);
+        cache->entries[i] = NULL;
+        
+        mem_cache_counts_t *counts = class_counts(i);
+        counts->spare -= mem_cache_fill(counts);
+    }
+}
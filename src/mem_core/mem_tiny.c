@@ -0,0 +1,484 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Tiny Objects
+ * ============================================================================
+ * 
+ * This file implements the headerless engine for requests of at most
+ * MEM_TINY_MAX bytes. Objects of one size class share a run whose header
+ * keeps a bitmap of free slots, found with count-trailing-zeros; the run
+ * of any object is its address rounded down to MEM_TINY_RUN_SIZE. All
+ * runs come from one reserved region committed on demand, and each run
+ * registers its page in the page map when it is carved. Each class has
+ * a lock and a list of runs with free slots. Threads keep a magazine of
+ * object pointers per class in TLS and move MEM_TINY_BATCH objects at a
+ * time to and from the runs; a TLS destructor returns the magazines when
+ * a thread exits. A magazine's length is kept as the counts of objects
+ * handed out and taken back in the thread's statistics block. Runs that
+ * become empty go back to a shared list of free runs, except the last
+ * run of a class with free slots.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <sys/mman.h>
+#include <string.h>
+
+typedef struct tiny_class {
+    pthread_mutex_t lock;
+    mem_tiny_run_t *partial;
+} tiny_class_t;
+
+typedef struct tiny_magazine {
+    void *slots[MEM_TINY_CLASSES][MEM_TINY_MAGAZINE];
+    unsigned generation;
+    bool registered;
+} tiny_magazine_t;
+
+static tiny_class_t classes[MEM_TINY_CLASSES];
+static char *region_start = NULL;
+static char *region_end = NULL;
+static char *region_limit = NULL;
+static char *next_run = NULL;
+static mem_tiny_run_t *free_runs = NULL;
+static pthread_mutex_t region_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread tiny_magazine_t magazine;
+static pthread_key_t magazine_key;
+static pthread_once_t magazine_key_once = PTHREAD_ONCE_INIT;
+
+size_t mem_tiny_class_size(size_t class_index)
+{
+    return (class_index + 1) * MEM_ALIGNMENT;
+}
+
+size_t mem_tiny_per_run(size_t class_index)
+{
+    return (MEM_TINY_RUN_SIZE - MEM_TINY_HEADER_SIZE) / mem_tiny_class_size(class_index);
+}
+
+static mem_tiny_run_t* run_of(void *ptr)
+{
+    return (mem_tiny_run_t*)((uintptr_t)ptr & ~(uintptr_t)(MEM_TINY_RUN_SIZE - 1));
+}
+
+static void link_run(mem_tiny_run_t **list, mem_tiny_run_t *run)
+{
+    run->prev = NULL;
+    run->next = *list;
+    if (*list != NULL) {
+        (*list)->prev = run;
+    }
+    *list = run;
+}
+
+static void unlink_run(mem_tiny_run_t **list, mem_tiny_run_t *run)
+{
+    if (run->prev != NULL) {
+        run->prev->next = run->next;
+    } else {
+        *list = run->next;
+    }
+    if (run->next != NULL) {
+        run->next->prev = run->prev;
+    }
+}
+
+/* ========================================================================== */
+/* REGION */
+/* ========================================================================== */
+
+int mem_tiny_init(void)
+{
+    char *start = mmap(NULL, MEM_TINY_RESERVE, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    
+    if (start == MAP_FAILED) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < MEM_TINY_CLASSES; i++) {
+        pthread_mutex_init(&classes[i].lock, NULL);
+        classes[i].partial = NULL;
+    }
+    region_end = start;
+    region_limit = start + MEM_TINY_RESERVE;
+    free_runs = NULL;
+    __atomic_store_n(&next_run, start, __ATOMIC_RELEASE);
+    __atomic_store_n(&region_start, start, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void mem_tiny_destroy(void)
+{
+    if (region_start == NULL) {
+        return;
+    }
+    
+    mem_page_map_clear(region_start, (size_t)(next_run - region_start));
+    munmap(region_start, MEM_TINY_RESERVE);
+    for (size_t i = 0; i < MEM_TINY_CLASSES; i++) {
+        pthread_mutex_destroy(&classes[i].lock);
+    }
+    __atomic_store_n(&region_start, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&next_run, NULL, __ATOMIC_RELEASE);
+}
+
+bool mem_tiny_owns(void *ptr)
+{
+    return mem_page_map_lookup(ptr, NULL) == MEM_PAGE_TINY;
+}
+
+static mem_tiny_run_t* carve_run(void)
+{
+    mem_tiny_run_t *run = (mem_tiny_run_t*)next_run;
+    
+    if (mem_page_map_set(run, MEM_TINY_RUN_SIZE, MEM_PAGE_TINY, NULL) != 0) {
+        return NULL;
+    }
+    if (next_run + MEM_TINY_RUN_SIZE > region_end) {
+        if (region_end == region_limit
+            || mprotect(region_end, MEM_TINY_COMMIT, PROT_READ | PROT_WRITE) != 0) {
+            mem_page_map_clear(run, MEM_TINY_RUN_SIZE);
+            return NULL;
+        }
+        region_end += MEM_TINY_COMMIT;
+    }
+    __atomic_store_n(&next_run, next_run + MEM_TINY_RUN_SIZE, __ATOMIC_RELEASE);
+    return run;
+}
+
+static mem_tiny_run_t* new_run(size_t class_index)
+{
+    pthread_mutex_lock(&region_lock);
+    mem_tiny_run_t *run = free_runs != NULL ? free_runs : carve_run();
+    if (run != NULL && run == free_runs) {
+        free_runs = run->next;
+    }
+    pthread_mutex_unlock(&region_lock);
+    if (run == NULL) {
+        return NULL;
+    }
+    
+    size_t count = mem_tiny_per_run(class_index);
+    for (size_t w = 0; w < MEM_TINY_BITMAP_WORDS; w++) {
+        uint64_t bits = count >= (w + 1) * 64 ? ~0ULL : count > w * 64 ? (1ULL << (count - w * 64)) - 1 : 0;
+        __atomic_store_n(&run->bitmap[w], bits, __ATOMIC_RELAXED);
+    }
+    run->free_count = count;
+    __atomic_store_n(&run->class_index, class_index, __ATOMIC_RELEASE);
+    return run;
+}
+
+static void retire_run(mem_tiny_run_t *run)
+{
+    __atomic_store_n(&run->class_index, (size_t)MEM_TINY_CLASSES, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&region_lock);
+    run->next = free_runs;
+    free_runs = run;
+    pthread_mutex_unlock(&region_lock);
+}
+
+/* ========================================================================== */
+/* RUNS */
+/* ========================================================================== */
+
+/* Up to count slots, clearing each bitmap word with a single atomic */
+static size_t take_slots(mem_tiny_run_t *run, size_t class_index, void **objects, size_t count)
+{
+    char *first = (char*)run + MEM_TINY_HEADER_SIZE;
+    size_t taken = 0;
+    
+    for (size_t w = 0; w < MEM_TINY_BITMAP_WORDS && taken < count; w++) {
+        uint64_t word = __atomic_load_n(&run->bitmap[w], __ATOMIC_RELAXED);
+        uint64_t grabbed = 0;
+        for (; word != 0 && taken < count; word &= word - 1) {
+            size_t bit = (size_t)__builtin_ctzll(word);
+            grabbed |= 1ULL << bit;
+            objects[taken++] = first + (w * 64 + bit) * mem_tiny_class_size(class_index);
+        }
+        if (grabbed != 0) {
+            __atomic_fetch_and(&run->bitmap[w], ~grabbed, __ATOMIC_RELAXED);
+        }
+    }
+    run->free_count -= taken;
+    return taken;
+}
+
+static void put_slot(tiny_class_t *cls, mem_tiny_run_t *run, size_t class_index, void *ptr)
+{
+    size_t slot = (size_t)((char*)ptr - (char*)run - MEM_TINY_HEADER_SIZE) / mem_tiny_class_size(class_index);
+    
+    __atomic_fetch_or(&run->bitmap[slot / 64], 1ULL << (slot % 64), __ATOMIC_RELAXED);
+    if (run->free_count++ == 0) {
+        link_run(&cls->partial, run);
+    }
+    if (run->free_count == mem_tiny_per_run(class_index) && (run->prev != NULL || run->next != NULL)) {
+        unlink_run(&cls->partial, run);
+        retire_run(run);
+    }
+}
+
+static size_t grab_batch(size_t class_index, void **objects, size_t count)
+{
+    tiny_class_t *cls = &classes[class_index];
+    size_t filled = 0;
+    
+    pthread_mutex_lock(&cls->lock);
+    while (filled < count) {
+        mem_tiny_run_t *run = cls->partial;
+        if (run == NULL && (run = new_run(class_index)) == NULL) {
+            break;
+        }
+        if (cls->partial == NULL) {
+            link_run(&cls->partial, run);
+        }
+        filled += take_slots(run, class_index, objects + filled, count - filled);
+        if (run->free_count == 0) {
+            unlink_run(&cls->partial, run);
+        }
+    }
+    pthread_mutex_unlock(&cls->lock);
+    
+    return filled;
+}
+
+static void return_batch(size_t class_index, void **objects, size_t count)
+{
+    tiny_class_t *cls = &classes[class_index];
+    
+    if (count == 0) {
+        return;
+    }
+    pthread_mutex_lock(&cls->lock);
+    for (size_t i = 0; i < count; i++) {
+        put_slot(cls, run_of(objects[i]), class_index, objects[i]);
+    }
+    pthread_mutex_unlock(&cls->lock);
+}
+
+/* Class of a live tiny object, or MEM_TINY_CLASSES for anything else */
+static size_t object_class(void *ptr)
+{
+    mem_tiny_run_t *run = run_of(ptr);
+    size_t class_index = __atomic_load_n(&run->class_index, __ATOMIC_ACQUIRE);
+    size_t offset = (size_t)((char*)ptr - (char*)run);
+    
+    if (class_index >= MEM_TINY_CLASSES || offset < MEM_TINY_HEADER_SIZE
+        || (offset - MEM_TINY_HEADER_SIZE) % mem_tiny_class_size(class_index) != 0) {
+        return MEM_TINY_CLASSES;
+    }
+    
+    size_t slot = (offset - MEM_TINY_HEADER_SIZE) / mem_tiny_class_size(class_index);
+    if (slot >= mem_tiny_per_run(class_index)
+        || (__atomic_load_n(&run->bitmap[slot / 64], __ATOMIC_RELAXED) >> (slot % 64)) & 1) {
+        return MEM_TINY_CLASSES;
+    }
+    return class_index;
+}
+
+/* ========================================================================== */
+/* MAGAZINES */
+/* ========================================================================== */
+
+static void magazine_destructor(void *arg)
+{
+    (void)arg;
+    mem_tiny_flush();
+    magazine.registered = false;
+}
+
+static void create_magazine_key(void)
+{
+    pthread_key_create(&magazine_key, magazine_destructor);
+}
+
+static tiny_magazine_t* current_magazine(void)
+{
+    tiny_magazine_t *mag = &magazine;
+    unsigned generation = __atomic_load_n(&mem_generation, __ATOMIC_ACQUIRE);
+    
+    if (mag->generation != generation) {
+        mem_stats_restart_cache(mem_thread_stats.tiny, MEM_TINY_CLASSES, &mem_thread_stats.tiny_generation);
+        mag->generation = generation;
+    }
+    
+    if (!mag->registered) {
+        pthread_once(&magazine_key_once, create_magazine_key);
+        pthread_setspecific(magazine_key, mag);
+        mag->registered = true;
+    }
+    return mag;
+}
+
+static mem_cache_counts_t* class_counts(size_t class_index)
+{
+    return &mem_stats_current()->tiny[class_index];
+}
+
+static bool magazine_holds(tiny_magazine_t *mag, size_t class_index, void *ptr)
+{
+    size_t fill = mem_cache_fill(class_counts(class_index));
+    
+    for (size_t i = 0; i < fill; i++) {
+        if (mag->slots[class_index][i] == ptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void* mem_tiny_alloc(size_t size)
+{
+    if (__atomic_load_n(&region_start, __ATOMIC_ACQUIRE) == NULL) {
+        return NULL;
+    }
+    
+    tiny_magazine_t *mag = current_magazine();
+    size_t class_index = (size - 1) / MEM_ALIGNMENT;
+    mem_cache_counts_t *counts = class_counts(class_index);
+    size_t fill = mem_cache_fill(counts);
+    
+    if (fill == 0) {
+        fill = grab_batch(class_index, mag->slots[class_index], MEM_TINY_BATCH);
+        if (fill == 0) {
+            return NULL;
+        }
+        counts->spare += fill;
+        mem_stats_publish_caches();
+    }
+    mem_stats_bump(&counts->allocs, 1);
+    return mag->slots[class_index][fill - 1];
+}
+
+static void stash_object(tiny_magazine_t *mag, size_t class_index, void *ptr)
+{
+    void **slots = mag->slots[class_index];
+    mem_cache_counts_t *counts = class_counts(class_index);
+    size_t fill = mem_cache_fill(counts);
+    
+    if (fill == MEM_TINY_MAGAZINE) {
+        return_batch(class_index, slots, MEM_TINY_MAGAZINE / 2);
+        memmove(slots, slots + MEM_TINY_MAGAZINE / 2, sizeof(void*) * (MEM_TINY_MAGAZINE / 2));
+        counts->spare -= MEM_TINY_MAGAZINE / 2;
+        fill = MEM_TINY_MAGAZINE / 2;
+    }
+    slots[fill] = ptr;
+    mem_stats_bump(&counts->frees, 1);
+}
+
+void mem_tiny_free(void *ptr)
+{
+    size_t class_index = object_class(ptr);
+    tiny_magazine_t *mag = current_magazine();
+    
+    if (class_index != MEM_TINY_CLASSES && !magazine_holds(mag, class_index, ptr)) {
+        stash_object(mag, class_index, ptr);
+    }
+}
+
+/*
+ * Trusts the caller's class once it matches the run's: no bitmap check
+ * and no double-free scan. Returns false, freeing nothing, on a mismatch.
+ */
+bool mem_tiny_free_class(void *ptr, size_t class_index)
+{
+    if (__atomic_load_n(&run_of(ptr)->class_index, __ATOMIC_ACQUIRE) != class_index) {
+        return false;
+    }
+    stash_object(current_magazine(), class_index, ptr);
+    return true;
+}
+
+/* Straight from the runs, under one class lock for the whole batch */
+size_t mem_tiny_alloc_batch(size_t size, void **objects, size_t count)
+{
+    if (__atomic_load_n(&region_start, __ATOMIC_ACQUIRE) == NULL) {
+        return 0;
+    }
+    return grab_batch((size - 1) / MEM_ALIGNMENT, objects, count);
+}
+
+/* Objects sorted by address; consecutive objects of one class share a lock */
+size_t mem_tiny_free_batch(void **objects, size_t count, size_t *bytes)
+{
+    tiny_magazine_t *mag = current_magazine();
+    tiny_class_t *locked = NULL;
+    size_t freed = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        size_t class_index = object_class(objects[i]);
+        if (class_index == MEM_TINY_CLASSES || magazine_holds(mag, class_index, objects[i])) {
+            continue;
+        }
+        if (&classes[class_index] != locked) {
+            if (locked != NULL) {
+                pthread_mutex_unlock(&locked->lock);
+            }
+            locked = &classes[class_index];
+            pthread_mutex_lock(&locked->lock);
+        }
+        put_slot(locked, run_of(objects[i]), class_index, objects[i]);
+        *bytes += mem_tiny_class_size(class_index);
+        freed++;
+    }
+    if (locked != NULL) {
+        pthread_mutex_unlock(&locked->lock);
+    }
+    return freed;
+}
+
+size_t mem_tiny_size(void *ptr)
+{
+    size_t class_index = object_class(ptr);
+    
+    return class_index == MEM_TINY_CLASSES ? 0 : mem_tiny_class_size(class_index);
+}
+
+void mem_tiny_flush(void)
+{
+    tiny_magazine_t *mag = current_magazine();
+    
+    for (size_t i = 0; i < MEM_TINY_CLASSES; i++) {
+        mem_cache_counts_t *counts = class_counts(i);
+        size_t fill = mem_cache_fill(counts);
+        
+        return_batch(i, mag->slots[i], fill);
+        counts->spare -= fill;
+    }
+}
+
+void mem_tiny_for_each_run(void (*visit)(mem_tiny_run_t *run, void *arg), void *arg)
+{
+    char *end = __atomic_load_n(&next_run, __ATOMIC_ACQUIRE);
+    char *run = __atomic_load_n(&region_start, __ATOMIC_ACQUIRE);
+    
+    for (; run != NULL && run < end; run += MEM_TINY_RUN_SIZE) {
+        if (__atomic_load_n(&((mem_tiny_run_t*)run)->class_index, __ATOMIC_ACQUIRE) < MEM_TINY_CLASSES) {
+            visit((mem_tiny_run_t*)run, arg);
+        }
+    }
+}
+
+void mem_tiny_lock_all(void)
+{
+    if (region_start == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < MEM_TINY_CLASSES; i++) {
+        pthread_mutex_lock(&classes[i].lock);
+    }
+    pthread_mutex_lock(&region_lock);
+}
+
+void mem_tiny_unlock_all(void)
+{
+    if (region_start == NULL) {
+        return;
+    }
+    pthread_mutex_unlock(&region_lock);
+    for (size_t i = MEM_TINY_CLASSES; i > 0; i--) {
+        pthread_mutex_unlock(&classes[i - 1].lock);
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Global operator new and delete
+ * ============================================================================
+ * 
+ * This file replaces every global allocation and deallocation function
+ * of C++17: plain, array, nothrow, align_val_t and sized forms. It is
+ * built into its own library by `make cpp`, so only programs that link
+ * that library route new and delete through the allocator. Throwing
+ * forms retry through the installed new_handler before throwing
+ * std::bad_alloc, as the standard requires. Sized forms all go through
+ * release(), which hands the size to mem_free_sized.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.hpp"
+#include <new>
+
+static void* allocate_or_throw(std::size_t size, std::size_t alignment)
+{
+    size = size != 0 ? size : 1;
+    for (;;) {
+        void *ptr = memalloc::allocate_bytes(size, alignment);
+        if (ptr != nullptr) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void* allocate_or_null(std::size_t size, std::size_t alignment) noexcept
+{
+    try {
+        return allocate_or_throw(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+static void release(void *ptr, std::size_t size) noexcept
+{
+    mem_free_sized(ptr, size != 0 ? size : 1);
+}
+
+/* ========================================================================== */
+/* ALLOCATION */
+/* ========================================================================== */
+
+void* operator new(std::size_t size)
+{
+    return allocate_or_throw(size, MEM_ALIGNMENT);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate_or_throw(size, MEM_ALIGNMENT);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate_or_null(size, MEM_ALIGNMENT);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate_or_null(size, MEM_ALIGNMENT);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate_or_null(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate_or_null(size, static_cast<std::size_t>(alignment));
+}
+
+/* ========================================================================== */
+/* DEALLOCATION */
+/* ========================================================================== */
+
+void operator delete(void *ptr) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t size) noexcept
+{
+    release(ptr, size);
+}
+
+void operator delete[](void *ptr, std::size_t size) noexcept
+{
+    release(ptr, size);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    mem_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t size, std::align_val_t) noexcept
+{
+    release(ptr, size);
+}
+
+void operator delete[](void *ptr, std::size_t size, std::align_val_t) noexcept
+{
+    release(ptr, size);
+}
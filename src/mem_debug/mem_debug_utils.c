@@ -4,50 +4,57 @@
  * ============================================================================
  * 
  * This file implements utility debug functions including defragmentation
- * and debug allocation tracking.
+ * and debug allocation tracking. MALLOC and FREE record live blocks in
+ * the leak table instead of printing every call.
  * 
  * ============================================================================
  */
 
 #include "../../include/mem_alloc.h"
 #include "../../include/mem_utils.h"
-#include <stdio.h>
 
-void mem_defragment(void)
+static void defragment_heap(mem_heap_t *heap, void *arg)
 {
-    if (first_block == NULL) {
-        return;
-    }
-    
-    mem_block_t *current = first_block;
+    mem_block_t *current = heap->first_block;
     
+    (void)arg;
+    mem_remote_free_drain(heap);
     while (current != NULL) {
-        if (current->is_free) {
-            mem_merge_blocks(current);
+        if (mem_block_is_free(current)) {
+            mem_bin_remove(heap, current);
+            current = mem_merge_blocks(heap, current);
         }
-        current = current->next;
+        current = mem_next_block(current);
     }
 }
 
+void mem_defragment(void)
+{
+    mem_for_each_heap(defragment_heap, NULL);
+}
+
 #ifdef DEBUG
 void* _mem_malloc_debug(size_t size, const char *file, int line)
 {
     void *ptr = mem_malloc(size);
     
     if (ptr != NULL) {
-        printf("DEBUG: Allocated %zu bytes at %p (%s:%d)\n", size, ptr, file, line);
+        mem_leak_track(ptr, size, file, line);
     }
     
     return ptr;
 }
 
+/* Untracked before the free, so a block reused at once is not dropped */
 void _mem_free_debug(void *ptr, const char *file, int line)
 {
     if (ptr == NULL) {
         return;
     }
     
-    printf("DEBUG: Freeing memory at %p (%s:%d)\n", ptr, file, line);
+    (void)file;
+    (void)line;
+    mem_leak_untrack(ptr);
     mem_free(ptr);
 }
 #endif
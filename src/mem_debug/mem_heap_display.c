@@ -13,42 +13,52 @@
 #include "../../include/mem_utils.h"
 #include <stdio.h>
 
-static void print_heap_header(void)
+static void print_heap_header(mem_heap_t *heap)
 {
     printf("========================================\n");
-    printf("HEAP MEMORY LAYOUT\n");
+    printf("HEAP MEMORY LAYOUT (heap %zu)\n", heap->index);
     printf("========================================\n");
-    printf("Heap range: %p - %p\n", heap_start, heap_end);
-    printf("Heap size:  %ld bytes\n", (char*)heap_end - (char*)heap_start);
+    printf("Heap range: %p - %p\n", heap->start, heap->end);
+    printf("Heap size:  %ld bytes\n", (char*)heap->end - (char*)heap->start);
+    printf("Reserved:   %ld bytes\n", (char*)heap->limit - (char*)heap->start);
     printf("----------------------------------------\n");
 }
 
 static void print_block_info(mem_block_t *block, int block_num)
 {
     printf("Block %d: %p\n", block_num, (void*)block);
-    printf("  Size:   %zu bytes\n", block->size);
-    printf("  Status: %s\n", block->is_free ? "FREE" : "ALLOCATED");
-    printf("  Magic:  0x%08X\n", block->magic);
+    printf("  Size:   %zu bytes\n", mem_block_size(block));
+    printf("  Status: %s\n", mem_block_is_free(block) ? "FREE"
+           : mem_tcache_is_cached(block) ? "CACHED" : "ALLOCATED");
+    printf("  Flags:  0x%zX%s%s\n", block->header & MEM_BLOCK_FLAGS,
+           mem_block_is_prev_free(block) ? " (prev free)" : "",
+           mem_block_is_free(block) && (block->header & MEM_BLOCK_CLEAN) ? " (clean)" : "");
     printf("  Data:   %p - %p\n", 
            mem_block_to_ptr(block),
-           (char*)mem_block_to_ptr(block) + block->size);
+           (char*)mem_block_to_ptr(block) + mem_block_size(block));
     printf("----------------------------------------\n");
 }
 
-void mem_print_heap(void)
+static void print_heap(mem_heap_t *heap, void *arg)
 {
-    if (first_block == NULL) {
-        printf("Heap not initialized\n");
-        return;
-    }
-    
-    print_heap_header();
-    
-    mem_block_t *current = first_block;
+    mem_block_t *current = heap->first_block;
     int block_num = 0;
     
+    (void)arg;
+    print_heap_header(heap);
+    
     while (current != NULL) {
         print_block_info(current, block_num++);
-        current = current->next;
+        current = mem_next_block(current);
     }
 }
+
+void mem_print_heap(void)
+{
+    if (__atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE) == 0) {
+        printf("Heap not initialized\n");
+        return;
+    }
+    
+    mem_for_each_heap(print_heap, NULL);
+}
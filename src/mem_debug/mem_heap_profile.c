@@ -0,0 +1,319 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Heap Profile
+ * ============================================================================
+ * 
+ * This file implements the sampling heap profiler. Every thread counts
+ * down the bytes it allocates from a random interval drawn from an
+ * exponential distribution whose mean is mem_sample_interval, so each
+ * byte has the same chance of being sampled and the allocation that
+ * crosses zero is sampled. A sampled allocation records its stack in a
+ * bucket shared by all samples of the same stack and is served from a
+ * mapping that points back to the bucket, so freeing it only costs a
+ * bucket update. Buckets live in an open-addressing table mapped on
+ * first use; stacks beyond its capacity are folded into one bucket with
+ * an empty stack. mem_heap_profile_dump writes the buckets in the heap
+ * profile format of gperftools, which pprof reads and scales back up to
+ * whole-heap estimates.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <execinfo.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BUCKET_SLOTS    ((size_t)1 << MEM_SAMPLE_BUCKET_BITS)
+#define BUCKET_MASK     (BUCKET_SLOTS - 1)
+#define LINE_SIZE       (64 + MEM_SAMPLE_DEPTH * 20)
+
+struct mem_sample_bucket {
+    uint64_t hash;
+    size_t depth;
+    void *frames[MEM_SAMPLE_DEPTH];
+    size_t alloc_count;
+    size_t alloc_bytes;
+    size_t free_count;
+    size_t free_bytes;
+};
+
+typedef struct bucket_table {
+    mem_sample_bucket_t slots[BUCKET_SLOTS];
+    mem_sample_bucket_t overflow;       /* stacks that found no free slot */
+} bucket_table_t;
+
+__thread ptrdiff_t mem_sample_countdown = 0;
+static __thread bool countdown_armed = false;
+static __thread uint64_t random_state = 0;
+
+static bucket_table_t *table = NULL;
+static size_t bucket_count = 0;
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* xorshift64*, seeded from the thread's own state address and the clock */
+static uint64_t next_random(void)
+{
+    if (random_state == 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        random_state = ((uint64_t)(uintptr_t)&random_state ^ (uint64_t)now.tv_nsec) | 1;
+    }
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return random_state * 0x2545F4914F6CDD1Dull;
+}
+
+/* Natural log of x in [1, 2) from the atanh series, without libm */
+static double log_mantissa(double x)
+{
+    double t = (x - 1.0) / (x + 1.0);
+    double t2 = t * t;
+    
+    return 2.0 * t * (1.0 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 / 9))));
+}
+
+/* Exponentially distributed with the given mean: -ln(u) * mean, u in (0, 1] */
+static ptrdiff_t next_interval(size_t mean)
+{
+    uint64_t bits = (next_random() >> 11) + 1;     /* u = bits / 2^53 */
+    int exponent = 63 - __builtin_clzll(bits);
+    double mantissa = (double)bits / (double)((uint64_t)1 << exponent);
+    double log_u = log_mantissa(mantissa) + (exponent - 53) * 0.6931471805599453;
+    double interval = -log_u * (double)mean;
+    
+    return interval < 1.0 ? 1 : interval > (double)PTRDIFF_MAX / 2 ? PTRDIFF_MAX / 2 : (ptrdiff_t)interval;
+}
+
+static uint64_t hash_frames(void **frames, size_t depth)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    
+    for (size_t i = 0; i < depth; i++) {
+        hash = (hash ^ (uint64_t)(uintptr_t)frames[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static bool same_stack(mem_sample_bucket_t *bucket, uint64_t hash, void **frames, size_t depth)
+{
+    return bucket->hash == hash && bucket->depth == depth
+           && memcmp(bucket->frames, frames, depth * sizeof(void*)) == 0;
+}
+
+/* One slot always stays empty so probing ends */
+static mem_sample_bucket_t* find_bucket(void **frames, size_t depth)
+{
+    uint64_t hash = hash_frames(frames, depth);
+    size_t slot = (size_t)(hash >> (64 - MEM_SAMPLE_BUCKET_BITS));
+    
+    while (table->slots[slot].depth != 0 && !same_stack(&table->slots[slot], hash, frames, depth)) {
+        slot = (slot + 1) & BUCKET_MASK;
+    }
+    
+    mem_sample_bucket_t *bucket = &table->slots[slot];
+    if (bucket->depth == 0) {
+        if (bucket_count == BUCKET_SLOTS - 1) {
+            return &table->overflow;
+        }
+        bucket->hash = hash;
+        bucket->depth = depth;
+        memcpy(bucket->frames, frames, depth * sizeof(void*));
+        bucket_count++;
+    }
+    return bucket;
+}
+
+static mem_sample_bucket_t* record_sample(void **frames, size_t depth, size_t size)
+{
+    mem_sample_bucket_t *bucket = NULL;
+    
+    pthread_mutex_lock(&profile_lock);
+    if (table == NULL) {
+        void *mapping = mmap(NULL, sizeof(bucket_table_t), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        table = mapping != MAP_FAILED ? mapping : NULL;
+    }
+    if (table != NULL) {
+        bucket = depth > 0 ? find_bucket(frames, depth) : &table->overflow;
+        bucket->alloc_count++;
+        bucket->alloc_bytes += size;
+    }
+    pthread_mutex_unlock(&profile_lock);
+    return bucket;
+}
+
+/* Kept out of line so the frame it adds is always the same one */
+static __attribute__((noinline)) size_t capture_stack(void **frames)
+{
+    void *raw[MEM_SAMPLE_DEPTH + 1];
+    int depth = backtrace(raw, MEM_SAMPLE_DEPTH + 1);
+    
+    if (depth <= 1) {
+        return 0;
+    }
+    memcpy(frames, raw + 1, (size_t)(depth - 1) * sizeof(void*));
+    return (size_t)depth - 1;
+}
+
+/*
+ * The first crossing after the interval changed only arms the countdown.
+ * The countdown is rearmed before the stack is captured, since the
+ * unwinder may allocate on its first use.
+ */
+void* mem_sample_alloc(size_t size)
+{
+    size_t interval = __atomic_load_n(&mem_sample_interval, __ATOMIC_RELAXED);
+    bool armed = countdown_armed;
+    void *frames[MEM_SAMPLE_DEPTH];
+    
+    countdown_armed = interval != 0;
+    mem_sample_countdown = interval != 0 ? next_interval(interval) : MEM_SAMPLE_RECHECK;
+    if (!armed || interval == 0 || size > PTRDIFF_MAX) {
+        return NULL;
+    }
+    
+    size_t depth = capture_stack(frames);
+    mem_sample_bucket_t *bucket = record_sample(frames, depth, size);
+    if (bucket == NULL) {
+        return NULL;
+    }
+    
+    void *ptr = mem_mmap_alloc_sampled(size, bucket);
+    if (ptr == NULL) {
+        mem_sample_release(bucket, size);
+    }
+    return ptr;
+}
+
+void mem_sample_release(mem_sample_bucket_t *bucket, size_t size)
+{
+    pthread_mutex_lock(&profile_lock);
+    bucket->free_count++;
+    bucket->free_bytes += size;
+    pthread_mutex_unlock(&profile_lock);
+}
+
+/* Forgets every sample and makes the calling thread draw a new interval */
+void mem_sample_reset(void)
+{
+    pthread_mutex_lock(&profile_lock);
+    if (table != NULL && bucket_count > 0) {
+        madvise(table, sizeof(bucket_table_t), MADV_DONTNEED);
+    }
+    if (table != NULL) {
+        memset(&table->overflow, 0, sizeof(table->overflow));
+    }
+    bucket_count = 0;
+    pthread_mutex_unlock(&profile_lock);
+    
+    mem_sample_countdown = 0;
+    countdown_armed = false;
+}
+
+void mem_sample_lock(void)
+{
+    pthread_mutex_lock(&profile_lock);
+}
+
+void mem_sample_unlock(void)
+{
+    pthread_mutex_unlock(&profile_lock);
+}
+
+/* ========================================================================== */
+/* PROFILE OUTPUT */
+/* ========================================================================== */
+
+/* Lines are formatted on the stack, so dumping never allocates */
+static bool write_all(int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool write_bucket(int fd, mem_sample_bucket_t *bucket)
+{
+    char line[LINE_SIZE];
+    int length = snprintf(line, sizeof(line), "%zu: %zu [%zu: %zu] @",
+                          bucket->alloc_count - bucket->free_count,
+                          bucket->alloc_bytes - bucket->free_bytes,
+                          bucket->alloc_count, bucket->alloc_bytes);
+    
+    for (size_t i = 0; i < bucket->depth; i++) {
+        length += snprintf(line + length, sizeof(line) - (size_t)length, " %p", bucket->frames[i]);
+    }
+    length += snprintf(line + length, sizeof(line) - (size_t)length, "\n");
+    return write_all(fd, line, (size_t)length);
+}
+
+static void add_totals(mem_sample_bucket_t *totals, mem_sample_bucket_t *bucket)
+{
+    totals->alloc_count += bucket->alloc_count;
+    totals->alloc_bytes += bucket->alloc_bytes;
+    totals->free_count += bucket->free_count;
+    totals->free_bytes += bucket->free_bytes;
+}
+
+/* pprof symbolizes the addresses with the mappings listed after the samples */
+static bool write_mappings(int fd)
+{
+    char buffer[4096];
+    int maps = open("/proc/self/maps", O_RDONLY);
+    ssize_t length;
+    bool written = maps >= 0 && write_all(fd, "\nMAPPED_LIBRARIES:\n", 19);
+    
+    while (written && (length = read(maps, buffer, sizeof(buffer))) > 0) {
+        written = write_all(fd, buffer, (size_t)length);
+    }
+    if (maps >= 0) {
+        close(maps);
+    }
+    return written;
+}
+
+int mem_heap_profile_dump(int fd)
+{
+    mem_sample_bucket_t totals;
+    char header[128];
+    bool written;
+    
+    memset(&totals, 0, sizeof(totals));
+    pthread_mutex_lock(&profile_lock);
+    for (size_t i = 0; table != NULL && i < BUCKET_SLOTS; i++) {
+        add_totals(&totals, &table->slots[i]);
+    }
+    if (table != NULL) {
+        add_totals(&totals, &table->overflow);
+    }
+    
+    snprintf(header, sizeof(header), "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+             totals.alloc_count - totals.free_count, totals.alloc_bytes - totals.free_bytes,
+             totals.alloc_count, totals.alloc_bytes,
+             __atomic_load_n(&mem_sample_interval, __ATOMIC_RELAXED));
+    written = write_all(fd, header, strlen(header));
+    for (size_t i = 0; written && table != NULL && i < BUCKET_SLOTS; i++) {
+        if (table->slots[i].depth != 0) {
+            written = write_bucket(fd, &table->slots[i]);
+        }
+    }
+    if (written && table != NULL && table->overflow.alloc_count != 0) {
+        written = write_bucket(fd, &table->overflow);
+    }
+    pthread_mutex_unlock(&profile_lock);
+    
+    return written && write_mappings(fd) ? 0 : -1;
+}
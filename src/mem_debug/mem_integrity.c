@@ -4,7 +4,11 @@
  * ============================================================================
  * 
  * This file implements heap integrity validation functions.
- * Validates block structure, magic numbers, and heap consistency.
+ * Validates block sizes, boundary tags, prev-free bits, the epilogue, the
+ * zero payload of clean free blocks and the agreement between the
+ * implicit block list and the free bins, including the (size, address)
+ * order of the size tree and the free totals the bins keep. Tiny runs
+ * must agree with their bitmaps.
  * 
  * ============================================================================
  */
@@ -13,48 +17,181 @@
 #include "../../include/mem_utils.h"
 #include <stdio.h>
 
-static bool validate_block(mem_block_t *current)
+static bool is_zeroed(mem_block_t *block)
 {
-    if (current->magic != MEM_MAGIC_ALLOCATED && current->magic != MEM_MAGIC_FREE) {
-        printf("ERROR: Invalid magic number in block %p\n", (void*)current);
+    size_t *word = (size_t*)((char*)mem_block_to_ptr(block) + MEM_CLEAN_OFFSET);
+    
+    for (; word < mem_block_footer(block); word++) {
+        if (*word != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool validate_block(mem_heap_t *heap, mem_block_t *current, bool prev_free)
+{
+    size_t size = mem_block_size(current);
+    
+    if (size < MEM_MIN_BLOCK_SIZE || (size + MEM_HEADER_SIZE) % MEM_ALIGNMENT != 0) {
+        printf("ERROR: Invalid size %zu in block %p\n", size, (void*)current);
         return false;
     }
     
-    if ((void*)current < heap_start || (void*)current >= heap_end) {
+    if ((void*)current < heap->start || (void*)mem_block_successor(current) >= heap->end) {
         printf("ERROR: Block %p outside heap boundaries\n", (void*)current);
         return false;
     }
     
-    if (current->next != NULL && current->next->prev != current) {
-        printf("ERROR: Broken next/prev link at block %p\n", (void*)current);
+    if (mem_block_is_prev_free(current) != prev_free) {
+        printf("ERROR: Stale prev-free bit at block %p\n", (void*)current);
+        return false;
+    }
+    
+    if (mem_block_is_free(current) && *mem_block_footer(current) != size) {
+        printf("ERROR: Footer mismatch at block %p\n", (void*)current);
+        return false;
+    }
+    
+    if (mem_block_is_free(current) && (current->header & MEM_BLOCK_CLEAN) && !is_zeroed(current)) {
+        printf("ERROR: Clean block %p holds non-zero bytes\n", (void*)current);
         return false;
     }
     
     return true;
 }
 
-bool mem_check_integrity(void)
+typedef struct tree_walk {
+    size_t count;
+    mem_block_t *prev;
+    bool ordered;
+} tree_walk_t;
+
+static void visit_tree_block(mem_block_t *block, void *arg)
 {
-    if (first_block == NULL) {
-        return true;
+    tree_walk_t *walk = arg;
+    
+    if (walk->prev != NULL && (mem_block_size(walk->prev) > mem_block_size(block)
+        || (mem_block_size(walk->prev) == mem_block_size(block) && walk->prev > block))) {
+        walk->ordered = false;
     }
+    walk->prev = block;
+    walk->count++;
+}
+
+static tree_walk_t walk_size_tree(mem_heap_t *heap)
+{
+    tree_walk_t walk = { 0, NULL, true };
     
-    mem_block_t *current = first_block;
-    size_t total_blocks = 0;
+    mem_tree_for_each(heap->large_tree, visit_tree_block, &walk);
+    return walk;
+}
+
+static size_t count_binned_blocks(mem_heap_t *heap)
+{
+    size_t count = walk_size_tree(heap).count;
     
-    while (current != NULL) {
-        if (!validate_block(current)) {
-            return false;
+    for (size_t i = 0; i < MEM_NUM_BINS; i++) {
+        mem_block_t *current = heap->free_bins[i];
+        while (current != NULL) {
+            count++;
+            current = ((mem_free_node_t*)mem_block_to_ptr(current))->next_free;
         }
-        total_blocks++;
-        current = current->next;
     }
-    
-    if (total_blocks != global_stats.num_blocks) {
+    return count;
+}
+
+typedef struct heap_walk {
+    size_t total_blocks;
+    size_t free_blocks;
+    size_t free_bytes;
+    size_t dirty_bytes;
+} heap_walk_t;
+
+static bool validate_totals(mem_heap_t *heap, const heap_walk_t *walk)
+{
+    if (walk->total_blocks != heap->num_blocks) {
         printf("ERROR: Block count mismatch. Found: %zu, Expected: %zu\n",
-               total_blocks, global_stats.num_blocks);
+               walk->total_blocks, heap->num_blocks);
+        return false;
+    }
+    
+    if (!walk_size_tree(heap).ordered) {
+        printf("ERROR: Size tree out of order in heap %p\n", heap->start);
+        return false;
+    }
+    
+    if (walk->free_blocks != count_binned_blocks(heap)) {
+        printf("ERROR: %zu free blocks in heap but %zu in bins\n",
+               walk->free_blocks, count_binned_blocks(heap));
+        return false;
+    }
+    
+    if (walk->free_blocks != heap->free_blocks || walk->free_bytes != heap->free_bytes
+        || walk->dirty_bytes != heap->dirty_bytes) {
+        printf("ERROR: %zu free blocks of %zu bytes (%zu dirty) in heap, counters say %zu of %zu (%zu)\n",
+               walk->free_blocks, walk->free_bytes, walk->dirty_bytes,
+               heap->free_blocks, heap->free_bytes, heap->dirty_bytes);
         return false;
     }
     
     return true;
 }
+
+static void check_heap(mem_heap_t *heap, void *arg)
+{
+    bool *valid = arg;
+    mem_block_t *current = heap->first_block;
+    heap_walk_t walk = { 0, 0, 0, 0 };
+    bool prev_free = false;
+    
+    while (current != NULL) {
+        if (!validate_block(heap, current, prev_free)) {
+            *valid = false;
+            return;
+        }
+        prev_free = mem_block_is_free(current);
+        if (prev_free) {
+            walk.free_blocks++;
+            walk.free_bytes += mem_block_size(current);
+            walk.dirty_bytes += (current->header & MEM_BLOCK_CLEAN) ? 0 : mem_block_size(current);
+        }
+        walk.total_blocks++;
+        current = mem_next_block(current);
+    }
+    
+    if (!validate_totals(heap, &walk)) {
+        *valid = false;
+    }
+}
+
+static void check_tiny_run(mem_tiny_run_t *run, void *arg)
+{
+    bool *valid = arg;
+    size_t per_run = mem_tiny_per_run(run->class_index);
+    size_t free_slots = 0;
+    
+    for (size_t w = 0; w < MEM_TINY_BITMAP_WORDS; w++) {
+        uint64_t word = __atomic_load_n(&run->bitmap[w], __ATOMIC_RELAXED);
+        uint64_t beyond = per_run >= (w + 1) * 64 ? 0 : per_run > w * 64 ? ~0ULL << (per_run - w * 64) : ~0ULL;
+        if (word & beyond) {
+            printf("ERROR: Tiny run %p marks slots past its end\n", (void*)run);
+            *valid = false;
+        }
+        free_slots += (size_t)__builtin_popcountll(word);
+    }
+    if (free_slots != run->free_count) {
+        printf("ERROR: Tiny run %p has %zu free slots, counted %zu\n",
+               (void*)run, free_slots, run->free_count);
+        *valid = false;
+    }
+}
+
+bool mem_check_integrity(void)
+{
+    bool valid = true;
+    
+    mem_for_each_heap(check_heap, &valid);
+    mem_tiny_for_each_run(check_tiny_run, &valid);
+    return valid;
+}
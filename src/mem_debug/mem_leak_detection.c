@@ -4,7 +4,14 @@
  * ============================================================================
  * 
  * This file implements memory leak detection and reporting functions.
- * Scans heap for unreleased allocated blocks.
+ * Scans heap for unreleased allocated blocks and lists live large
+ * mappings. Blocks parked in a thread cache were released by the program
+ * and are not reported. Live arenas are summarized as well, since their
+ * chunks only show up as a few large blocks. Tiny objects are counted
+ * per run after the calling thread returns its magazines; objects held
+ * in other threads' magazines still count as live. Blocks recorded by
+ * MALLOC are not listed one by one but grouped by call site, with their
+ * count, bytes and the age of the oldest one.
  * 
  * ============================================================================
  */
@@ -22,33 +29,80 @@ static void print_leak_header(void)
 
 static bool process_leak_block(mem_block_t *current, bool *leaks_found)
 {
-    if (!current->is_free && current->magic == MEM_MAGIC_ALLOCATED) {
+    if (!mem_block_is_free(current) && !mem_tcache_is_cached(current)) {
+        if (mem_leak_is_tracked(mem_block_to_ptr(current))) {
+            return true;
+        }
         if (!*leaks_found) {
             *leaks_found = true;
             printf("Memory leaks detected:\n");
             printf("----------------------------------------\n");
         }
         printf("LEAK: %zu bytes at %p\n", 
-               current->size, mem_block_to_ptr(current));
+               mem_block_size(current), mem_block_to_ptr(current));
         return true;
     }
     return false;
 }
 
+static void scan_heap(mem_heap_t *heap, void *arg)
+{
+    mem_block_t *current = heap->first_block;
+    
+    while (current != NULL) {
+        process_leak_block(current, arg);
+        current = mem_next_block(current);
+    }
+}
+
+static void report_mapping(mem_block_t *block, void *arg)
+{
+    process_leak_block(block, arg);
+}
+
+static void report_arena(mem_arena_t *arena, void *arg)
+{
+    mem_arena_stats_t stats = { 0, 0, 0 };
+    
+    (void)arg;
+    mem_arena_get_stats(arena, &stats);
+    printf("LIVE ARENA: %zu bytes used in %zu chunks at %p\n",
+           stats.used_bytes, stats.chunk_count, (void*)arena);
+}
+
+static void report_tiny_run(mem_tiny_run_t *run, void *arg)
+{
+    bool *leaks_found = arg;
+    size_t live = mem_tiny_per_run(run->class_index) - run->free_count;
+    
+    if (live == 0) {
+        return;
+    }
+    if (!*leaks_found) {
+        *leaks_found = true;
+        printf("Memory leaks detected:\n");
+        printf("----------------------------------------\n");
+    }
+    printf("LEAK: %zu bytes in %zu tiny objects in run %p\n",
+           live * mem_tiny_class_size(run->class_index), live, (void*)run);
+}
+
 void mem_detect_leaks(void)
 {
-    if (first_block == NULL) {
+    if (__atomic_load_n(&mem_heap_count, __ATOMIC_ACQUIRE) == 0) {
         return;
     }
     
-    mem_block_t *current = first_block;
     bool leaks_found = false;
     
     print_leak_header();
-    
-    while (current != NULL) {
-        process_leak_block(current, &leaks_found);
-        current = current->next;
+    mem_for_each_heap(scan_heap, &leaks_found);
+    mem_mmap_for_each(report_mapping, &leaks_found);
+    mem_tiny_flush();
+    mem_tiny_for_each_run(report_tiny_run, &leaks_found);
+    mem_arena_for_each(report_arena, NULL);
+    if (mem_leak_report_sites()) {
+        leaks_found = true;
     }
     
     if (!leaks_found) {
@@ -0,0 +1,281 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Leak Table
+ * ============================================================================
+ * 
+ * This file implements the table of live blocks behind MALLOC and FREE
+ * in DEBUG builds. It is an open-addressing hash table keyed by pointer
+ * with linear probing; removals shift the following entries back, so no
+ * tombstones build up under churn. The slots and the scratch space used
+ * to group blocks by call site share one mapping made on first use, so
+ * recording a block never allocates. A full table stops recording and
+ * counts what it missed instead of growing.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define TABLE_SLOTS     ((size_t)1 << MEM_LEAK_TABLE_BITS)
+#define TABLE_MASK      (TABLE_SLOTS - 1)
+#define TABLE_LIMIT     (TABLE_SLOTS * MEM_LEAK_TABLE_LOAD / 100)
+#define SITE_SLOTS      ((size_t)1 << MEM_LEAK_SITE_BITS)
+#define SITE_MASK       (SITE_SLOTS - 1)
+
+typedef struct leak_site {
+    const char *file;
+    int line;
+    size_t count;
+    size_t bytes;
+    uint64_t oldest_ns;
+} leak_site_t;
+
+typedef struct leak_table {
+    mem_leak_t slots[TABLE_SLOTS];
+    leak_site_t sites[SITE_SLOTS];
+} leak_table_t;
+
+static leak_table_t *table = NULL;
+static size_t tracked = 0;
+static size_t untracked = 0;            /* blocks missed while the table was full */
+static pthread_mutex_t leak_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The coarse clock is a plain read of the vDSO page; leak ages need no more */
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/* Fibonacci hashing spreads the aligned low bits over the whole index */
+static size_t home_slot(void *ptr)
+{
+    return (size_t)(((uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ull) >> (64 - MEM_LEAK_TABLE_BITS));
+}
+
+static leak_table_t* map_table(void)
+{
+    void *mapping = mmap(NULL, sizeof(leak_table_t), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    
+    return mapping != MAP_FAILED ? mapping : NULL;
+}
+
+/* Returns the slot holding ptr, or the empty slot ending its probe sequence */
+static size_t find_slot(void *ptr)
+{
+    size_t slot = home_slot(ptr);
+    
+    while (table->slots[slot].ptr != NULL && table->slots[slot].ptr != ptr) {
+        slot = (slot + 1) & TABLE_MASK;
+    }
+    return slot;
+}
+
+/* Moves later entries of the probe sequence into the hole so lookups still reach them */
+static void remove_slot(size_t hole)
+{
+    size_t next = hole;
+    
+    for (;;) {
+        next = (next + 1) & TABLE_MASK;
+        if (table->slots[next].ptr == NULL) {
+            break;
+        }
+        size_t home = home_slot(table->slots[next].ptr);
+        if (((next - home) & TABLE_MASK) >= ((next - hole) & TABLE_MASK)) {
+            table->slots[hole] = table->slots[next];
+            hole = next;
+        }
+    }
+    table->slots[hole].ptr = NULL;
+}
+
+void mem_leak_track(void *ptr, size_t size, const char *file, int line)
+{
+    uint64_t timestamp = now_ns();
+    
+    pthread_mutex_lock(&leak_lock);
+    if (table == NULL) {
+        table = map_table();
+    }
+    if (table == NULL) {
+        untracked++;
+        pthread_mutex_unlock(&leak_lock);
+        return;
+    }
+    
+    size_t slot = find_slot(ptr);
+    if (table->slots[slot].ptr == NULL) {
+        if (tracked >= TABLE_LIMIT) {
+            untracked++;
+            pthread_mutex_unlock(&leak_lock);
+            return;
+        }
+        tracked++;
+    }
+    table->slots[slot] = (mem_leak_t){ ptr, size, file, line, timestamp };
+    pthread_mutex_unlock(&leak_lock);
+}
+
+void mem_leak_untrack(void *ptr)
+{
+    pthread_mutex_lock(&leak_lock);
+    if (table != NULL) {
+        size_t slot = find_slot(ptr);
+        if (table->slots[slot].ptr != NULL) {
+            remove_slot(slot);
+            tracked--;
+        }
+    }
+    pthread_mutex_unlock(&leak_lock);
+}
+
+bool mem_leak_is_tracked(void *ptr)
+{
+    bool found;
+    
+    pthread_mutex_lock(&leak_lock);
+    found = table != NULL && table->slots[find_slot(ptr)].ptr != NULL;
+    pthread_mutex_unlock(&leak_lock);
+    return found;
+}
+
+size_t mem_get_leaks(mem_leak_t *leaks, size_t max)
+{
+    size_t count;
+    size_t copied = 0;
+    
+    pthread_mutex_lock(&leak_lock);
+    count = tracked;
+    for (size_t i = 0; table != NULL && i < TABLE_SLOTS && copied < max; i++) {
+        if (table->slots[i].ptr != NULL) {
+            leaks[copied++] = table->slots[i];
+        }
+    }
+    pthread_mutex_unlock(&leak_lock);
+    return count;
+}
+
+static size_t site_slot(const char *file, int line)
+{
+    size_t slot = (size_t)(((uint32_t)line * 0x9E3779B1u) >> (32 - MEM_LEAK_SITE_BITS));
+    
+    while (table->sites[slot].file != NULL &&
+           (table->sites[slot].line != line || strcmp(table->sites[slot].file, file) != 0)) {
+        slot = (slot + 1) & SITE_MASK;
+    }
+    return slot;
+}
+
+/* One slot always stays empty so probing ends; later sites go to other */
+static leak_site_t* site_of(mem_leak_t *leak, size_t *sites, leak_site_t *other)
+{
+    leak_site_t *site = &table->sites[site_slot(leak->file, leak->line)];
+    
+    if (site->file == NULL) {
+        if (*sites == SITE_SLOTS - 1) {
+            return other;
+        }
+        *site = (leak_site_t){ leak->file, leak->line, 0, 0, leak->timestamp_ns };
+        (*sites)++;
+    }
+    return site;
+}
+
+static size_t group_by_site(leak_site_t *other)
+{
+    size_t sites = 0;
+    
+    memset(table->sites, 0, sizeof(table->sites));
+    for (size_t i = 0; i < TABLE_SLOTS; i++) {
+        mem_leak_t *leak = &table->slots[i];
+        if (leak->ptr == NULL) {
+            continue;
+        }
+        
+        leak_site_t *site = site_of(leak, &sites, other);
+        site->count++;
+        site->bytes += leak->size;
+        if (leak->timestamp_ns < site->oldest_ns) {
+            site->oldest_ns = leak->timestamp_ns;
+        }
+    }
+    return sites;
+}
+
+static int compare_sites(const void *a, const void *b)
+{
+    const leak_site_t *left = a;
+    const leak_site_t *right = b;
+    
+    if (left->file == NULL || right->file == NULL) {
+        return (left->file == NULL) - (right->file == NULL);
+    }
+    return (left->bytes < right->bytes) - (left->bytes > right->bytes);
+}
+
+/* Returns whether anything was reported */
+bool mem_leak_report_sites(void)
+{
+    pthread_mutex_lock(&leak_lock);
+    if (table == NULL || tracked == 0) {
+        pthread_mutex_unlock(&leak_lock);
+        return false;
+    }
+    
+    leak_site_t other = { "other call sites", 0, 0, 0, UINT64_MAX };
+    size_t sites = group_by_site(&other);
+    uint64_t now = now_ns();
+    
+    qsort(table->sites, SITE_SLOTS, sizeof(leak_site_t), compare_sites);
+    printf("Leaks by call site:\n");
+    printf("----------------------------------------\n");
+    for (size_t i = 0; i < sites && i < MEM_LEAK_REPORT_SITES; i++) {
+        leak_site_t *site = &table->sites[i];
+        printf("LEAK: %zu bytes in %zu blocks at %s:%d (oldest %.3fs)\n",
+               site->bytes, site->count, site->file, site->line,
+               (double)(now - site->oldest_ns) / 1e9);
+    }
+    if (sites > MEM_LEAK_REPORT_SITES) {
+        printf("... and %zu more call sites\n", sites - MEM_LEAK_REPORT_SITES);
+    }
+    if (other.count > 0) {
+        printf("LEAK: %zu bytes in %zu blocks at %s\n", other.bytes, other.count, other.file);
+    }
+    if (untracked > 0) {
+        printf("%zu more blocks were not recorded: leak table full\n", untracked);
+    }
+    pthread_mutex_unlock(&leak_lock);
+    return true;
+}
+
+/* Dropping the pages zeroes the table without touching it */
+void mem_leak_reset(void)
+{
+    pthread_mutex_lock(&leak_lock);
+    if (table != NULL && tracked > 0) {
+        madvise(table, sizeof(leak_table_t), MADV_DONTNEED);
+    }
+    tracked = 0;
+    untracked = 0;
+    pthread_mutex_unlock(&leak_lock);
+}
+
+void mem_leak_lock(void)
+{
+    pthread_mutex_lock(&leak_lock);
+}
+
+void mem_leak_unlock(void)
+{
+    pthread_mutex_unlock(&leak_lock);
+}
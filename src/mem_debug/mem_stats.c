@@ -4,7 +4,20 @@
  * ============================================================================
  * 
  * This file implements statistics collection and display functions
- * for the memory allocator.
+ * for the memory allocator. Each thread counts its own allocations and
+ * frees in thread-local counters that no other thread writes, since the
+ * cache fast paths run on many threads at once without any heap lock;
+ * readers add up the counters of every thread under the registry lock.
+ * Blocks served by the thread caches are not counted again: the caches
+ * keep per-class counts of what they hand out and take back, and the
+ * readers turn those into the totals for each class size.
+ * Peak usage is raised whenever a thread publishes a large change of
+ * its usage and whenever the statistics are read. Free memory is
+ * totalled by the bins of each heap as blocks come and go, so
+ * mem_get_stats only adds up a few counters per heap and finds the
+ * largest free block at the end of the size tree; it never walks the
+ * blocks. Fragmentation is the share of free heap bytes that lies
+ * outside the largest free block, 1 - largest / free.
  * 
  * ============================================================================
  */
@@ -14,35 +27,393 @@
 #include <stdio.h>
 #include <string.h>
 
-static void calculate_heap_metrics(mem_stats_t *stats)
+typedef struct heap_totals {
+    size_t num_blocks;
+    size_t free_bytes;
+    size_t free_blocks;
+    size_t dirty_bytes;
+    size_t largest_free;
+} heap_totals_t;
+
+/* The counters are read as an array of words */
+#define COUNTER_WORDS           (sizeof(mem_stats_counters_t) / sizeof(size_t))
+
+__thread mem_thread_stats_t mem_thread_stats;
+static mem_thread_stats_t *live_threads = NULL;
+static mem_stats_counters_t exited_threads;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t stats_key;
+static pthread_once_t stats_key_once = PTHREAD_ONCE_INIT;
+
+static size_t load_counter(size_t *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static void add_counters(mem_stats_counters_t *sum, mem_stats_counters_t *counters)
+{
+    size_t *to = (size_t*)sum;
+    size_t *from = (size_t*)counters;
+    
+    for (size_t i = 0; i < COUNTER_WORDS; i++) {
+        to[i] += load_counter(&from[i]);
+    }
+}
+
+static void clear_counters(mem_stats_counters_t *counters)
+{
+    size_t *words = (size_t*)counters;
+    
+    for (size_t i = 0; i < COUNTER_WORDS; i++) {
+        __atomic_store_n(&words[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+static size_t tcache_class_size(size_t index)
+{
+    return MEM_MIN_BLOCK_SIZE + index * MEM_ALIGNMENT;
+}
+
+static void add_cache(mem_stats_counters_t *sum, mem_cache_counts_t *counts, size_t size)
+{
+    size_t allocs = load_counter(&counts->allocs);
+    size_t frees = load_counter(&counts->frees);
+    
+    sum->num_allocations += allocs;
+    sum->total_allocated += allocs * size;
+    sum->requests[mem_stats_class(size)] += allocs;
+    sum->num_frees += frees;
+    sum->total_freed += frees * size;
+}
+
+/*
+ * The caches count even with statistics disabled, so their counts only
+ * show when enabled. Counts left from before the last mem_init are
+ * skipped until their cache restarts.
+ */
+static void add_caches(mem_stats_counters_t *sum, mem_thread_stats_t *stats)
+{
+    unsigned generation = __atomic_load_n(&mem_generation, __ATOMIC_ACQUIRE);
+    
+    if (!mem_stats_enabled) {
+        return;
+    }
+    for (size_t i = 0; stats->tcache_generation == generation && i < MEM_TCACHE_CLASSES; i++) {
+        add_cache(sum, &stats->tcache[i], tcache_class_size(i));
+    }
+    for (size_t i = 0; stats->tiny_generation == generation && i < MEM_TINY_CLASSES; i++) {
+        add_cache(sum, &stats->tiny[i], mem_tiny_class_size(i));
+    }
+}
+
+/* Keeps each list's length while its counts start over */
+static void rebase_caches(mem_cache_counts_t *counts, size_t classes)
+{
+    for (size_t i = 0; i < classes; i++) {
+        counts[i].spare = mem_cache_fill(&counts[i]);
+        __atomic_store_n(&counts[i].allocs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&counts[i].frees, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* Folds the counters of an exiting thread into the shared totals */
+static void retire_thread(void *arg)
+{
+    mem_thread_stats_t *stats = arg;
+    
+    pthread_mutex_lock(&stats_lock);
+    add_counters(&exited_threads, &stats->counters);
+    add_caches(&exited_threads, stats);
+    clear_counters(&stats->counters);
+    rebase_caches(stats->tcache, MEM_TCACHE_CLASSES);
+    rebase_caches(stats->tiny, MEM_TINY_CLASSES);
+    if (stats->prev != NULL) {
+        stats->prev->next = stats->next;
+    } else {
+        live_threads = stats->next;
+    }
+    if (stats->next != NULL) {
+        stats->next->prev = stats->prev;
+    }
+    stats->registered = false;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static void create_stats_key(void)
+{
+    pthread_key_create(&stats_key, retire_thread);
+}
+
+/* Registered before setspecific, which may allocate */
+void mem_stats_register_thread(void)
+{
+    mem_thread_stats_t *stats = &mem_thread_stats;
+    
+    stats->registered = true;
+    pthread_mutex_lock(&stats_lock);
+    stats->prev = NULL;
+    stats->next = live_threads;
+    if (live_threads != NULL) {
+        live_threads->prev = stats;
+    }
+    live_threads = stats;
+    pthread_mutex_unlock(&stats_lock);
+    
+    pthread_once(&stats_key_once, create_stats_key);
+    pthread_setspecific(stats_key, stats);
+}
+
+static mem_stats_counters_t* current_counters(void)
+{
+    return &mem_stats_current()->counters;
+}
+
+static void raise_peak(size_t usage)
+{
+    size_t peak = load_counter(&global_stats.peak_usage);
+    
+    while (usage > peak && !__atomic_compare_exchange_n(&global_stats.peak_usage, &peak, usage,
+                                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/* Usage may be negative for a thread that frees what others allocated */
+static void publish(size_t *published, size_t usage)
+{
+    ptrdiff_t change = (ptrdiff_t)(usage - *published);
+    
+    if (change < MEM_STATS_PUBLISH && change > -MEM_STATS_PUBLISH) {
+        return;
+    }
+    mem_stats_bump(published, (size_t)change);
+    raise_peak(__atomic_add_fetch(&mem_published_usage, (size_t)change, __ATOMIC_RELAXED));
+}
+
+static void publish_usage(mem_stats_counters_t *counters)
+{
+    publish(&counters->published, counters->total_allocated - counters->total_freed - counters->shrunk);
+}
+
+/* A cache whose lists mem_init dropped starts its counts over */
+void mem_stats_restart_cache(mem_cache_counts_t *counts, size_t classes, unsigned *generation)
+{
+    pthread_mutex_lock(&stats_lock);
+    memset(counts, 0, classes * sizeof(mem_cache_counts_t));
+    *generation = __atomic_load_n(&mem_generation, __ATOMIC_ACQUIRE);
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/* Called by the caches when they take a batch, which is when their usage grows */
+void mem_stats_publish_caches(void)
+{
+    mem_thread_stats_t *stats = mem_stats_current();
+    size_t usage = 0;
+    
+    if (!mem_stats_enabled) {
+        return;
+    }
+    for (size_t i = 0; i < MEM_TCACHE_CLASSES; i++) {
+        usage += (stats->tcache[i].allocs - stats->tcache[i].frees) * tcache_class_size(i);
+    }
+    for (size_t i = 0; i < MEM_TINY_CLASSES; i++) {
+        usage += (stats->tiny[i].allocs - stats->tiny[i].frees) * mem_tiny_class_size(i);
+    }
+    publish(&stats->counters.published_caches, usage);
+}
+
+size_t mem_stats_class(size_t size)
 {
-    size_t free_blocks = 0;
-    size_t free_memory = 0;
-    size_t total_memory = 0;
+    size_t index = size < 16 ? 0 : (size_t)(63 - __builtin_clzll(size)) - 3;
     
-    mem_block_t *current = first_block;
-    while (current != NULL) {
-        total_memory += current->size + sizeof(mem_block_t);
-        if (current->is_free) {
-            free_blocks++;
-            free_memory += current->size;
+    return index < MEM_STATS_CLASSES ? index : MEM_STATS_CLASSES - 1;
+}
+
+void mem_stats_reset(void)
+{
+    pthread_mutex_lock(&stats_lock);
+    clear_counters(&exited_threads);
+    for (mem_thread_stats_t *stats = live_threads; stats != NULL; stats = stats->next) {
+        clear_counters(&stats->counters);
+    }
+    memset(&global_stats, 0, sizeof(mem_stats_t));
+    __atomic_store_n(&mem_published_usage, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void mem_stats_lock(void)
+{
+    pthread_mutex_lock(&stats_lock);
+}
+
+void mem_stats_unlock(void)
+{
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void mem_stats_record_allocations(size_t count, size_t bytes)
+{
+    if (mem_stats_enabled && count > 0) {
+        mem_stats_counters_t *counters = current_counters();
+        mem_stats_bump(&counters->num_allocations, count);
+        mem_stats_bump(&counters->total_allocated, bytes);
+        mem_stats_bump(&counters->requests[mem_stats_class(bytes / count)], count);
+        publish_usage(counters);
+    }
+}
+
+void mem_stats_record_frees(size_t count, size_t bytes)
+{
+    if (mem_stats_enabled) {
+        mem_stats_counters_t *counters = current_counters();
+        mem_stats_bump(&counters->num_frees, count);
+        mem_stats_bump(&counters->total_freed, bytes);
+    }
+}
+
+void mem_stats_record_shrink(size_t size)
+{
+    if (mem_stats_enabled) {
+        mem_stats_bump(&current_counters()->shrunk, size);
+    }
+}
+
+void mem_stats_record_growth(size_t size)
+{
+    if (mem_stats_enabled) {
+        mem_stats_counters_t *counters = current_counters();
+        mem_stats_bump(&counters->total_allocated, size);
+        publish_usage(counters);
+    }
+}
+
+static void sum_counters(mem_stats_counters_t *sum)
+{
+    memset(sum, 0, sizeof(*sum));
+    pthread_mutex_lock(&stats_lock);
+    add_counters(sum, &exited_threads);
+    for (mem_thread_stats_t *stats = live_threads; stats != NULL; stats = stats->next) {
+        add_counters(sum, &stats->counters);
+        add_caches(sum, stats);
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/* The size tree holds the largest blocks; otherwise the highest non-empty bin does */
+static size_t largest_free_block(mem_heap_t *heap)
+{
+    mem_block_t *largest = mem_tree_largest(heap->large_tree);
+    
+    for (size_t w = MEM_BITMAP_WORDS; largest == NULL && w > 0; w--) {
+        if (heap->bin_bitmap[w - 1] != 0) {
+            largest = heap->free_bins[(w - 1) * 64 + 63 - (size_t)__builtin_clzll(heap->bin_bitmap[w - 1])];
         }
-        current = current->next;
     }
+    return largest != NULL ? mem_block_size(largest) : 0;
+}
+
+static void accumulate_heap(mem_heap_t *heap, void *arg)
+{
+    heap_totals_t *totals = arg;
+    size_t largest = largest_free_block(heap);
     
-    if (total_memory > 0) {
-        stats->fragmentation_ratio = (free_memory * 100) / total_memory;
+    totals->num_blocks += heap->num_blocks;
+    totals->free_bytes += heap->free_bytes;
+    totals->free_blocks += heap->free_blocks;
+    totals->dirty_bytes += heap->dirty_bytes;
+    if (largest > totals->largest_free) {
+        totals->largest_free = largest;
     }
 }
 
 void mem_get_stats(mem_stats_t *stats)
 {
+    heap_totals_t totals;
+    mem_stats_counters_t counters;
+    
     if (stats == NULL) {
         return;
     }
     
-    memcpy(stats, &global_stats, sizeof(mem_stats_t));
-    calculate_heap_metrics(stats);
+    memset(&totals, 0, sizeof(totals));
+    mem_for_each_heap(accumulate_heap, &totals);
+    sum_counters(&counters);
+    
+    stats->total_allocated = counters.total_allocated;
+    stats->total_freed = counters.total_freed;
+    stats->current_usage = counters.total_allocated - counters.total_freed - counters.shrunk;
+    raise_peak(stats->current_usage);
+    stats->peak_usage = load_counter(&global_stats.peak_usage);
+    stats->num_allocations = counters.num_allocations;
+    stats->num_frees = counters.num_frees;
+    stats->num_blocks = totals.num_blocks + mem_mmap_count();
+    stats->purged_bytes = load_counter(&global_stats.purged_bytes);
+    stats->retained_bytes = totals.dirty_bytes;
+    stats->free_bytes = totals.free_bytes;
+    stats->free_blocks = totals.free_blocks;
+    stats->largest_free = totals.largest_free;
+    stats->fragmentation_ratio = 0;
+    if (totals.free_bytes > 0) {
+        stats->fragmentation_ratio = (totals.free_bytes - totals.largest_free) * 100 / totals.free_bytes;
+    }
+}
+
+static void accumulate_histogram(mem_heap_t *heap, void *arg)
+{
+    mem_size_histogram_t *histogram = arg;
+    
+    for (size_t i = 0; i < MEM_STATS_CLASSES; i++) {
+        histogram->free_blocks[i] += heap->free_histogram[i];
+    }
+}
+
+void mem_get_size_histogram(mem_size_histogram_t *histogram)
+{
+    mem_stats_counters_t counters;
+    
+    if (histogram == NULL) {
+        return;
+    }
+    
+    memset(histogram, 0, sizeof(*histogram));
+    sum_counters(&counters);
+    for (size_t i = 0; i < MEM_STATS_CLASSES; i++) {
+        histogram->requests[i] = counters.requests[i];
+    }
+    mem_for_each_heap(accumulate_histogram, histogram);
+}
+
+static void print_histogram(void)
+{
+    mem_size_histogram_t histogram;
+    
+    mem_get_size_histogram(&histogram);
+    printf("Size class          Requests   Free blocks\n");
+    for (size_t i = 0; i < MEM_STATS_CLASSES; i++) {
+        if (histogram.requests[i] != 0 || histogram.free_blocks[i] != 0) {
+            printf("  >= %-10zu %12zu %13zu\n", (size_t)8 << i, histogram.requests[i], histogram.free_blocks[i]);
+        }
+    }
+}
+
+static void print_pool(mem_pool_t *pool, void *arg)
+{
+    mem_pool_stats_t stats;
+    
+    (void)arg;
+    mem_pool_get_stats(pool, &stats);
+    printf("Pool %p: %zu-byte objects, %zu in use, %zu free, %zu slabs (%zu bytes)\n",
+           (void*)pool, stats.object_size, stats.objects_in_use, stats.objects_free,
+           stats.slab_count, stats.slab_bytes);
+}
+
+static void print_arena(mem_arena_t *arena, void *arg)
+{
+    mem_arena_stats_t stats = { 0, 0, 0 };
+    
+    (void)arg;
+    mem_arena_get_stats(arena, &stats);
+    printf("Arena %p: %zu bytes used, %zu chunks (%zu bytes)\n",
+           (void*)arena, stats.used_bytes, stats.chunk_count, stats.chunk_bytes);
 }
 
 void mem_print_stats(void)
@@ -60,6 +431,13 @@ void mem_print_stats(void)
     printf("Number of allocs:   %zu\n", stats.num_allocations);
     printf("Number of frees:    %zu\n", stats.num_frees);
     printf("Active blocks:      %zu\n", stats.num_blocks);
+    printf("Free heap memory:   %zu bytes in %zu blocks, largest %zu\n",
+           stats.free_bytes, stats.free_blocks, stats.largest_free);
     printf("Fragmentation:      %zu%%\n", stats.fragmentation_ratio);
+    printf("Purged to OS:       %zu bytes\n", stats.purged_bytes);
+    printf("Retained free:      %zu bytes\n", stats.retained_bytes);
+    print_histogram();
+    mem_pool_for_each(print_pool, NULL);
+    mem_arena_for_each(print_arena, NULL);
     printf("========================================\n");
 }
@@ -0,0 +1,108 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - LD_PRELOAD Shim
+ * ============================================================================
+ * 
+ * This file is only built into libmemalloc_preload.so, which replaces
+ * the libc allocation family in any dynamically linked program started
+ * with LD_PRELOAD. Every entry point forwards to the mem_* API and none
+ * forwards to libc, so there is no dlsym lookup that could recurse into
+ * malloc. The allocator initializes itself on the first request without
+ * allocating, which covers requests made before main and by the dynamic
+ * loader. Pointers the allocator does not own, such as those handed out
+ * by the loader's bootstrap allocator, are ignored by free. The fork
+ * handlers are registered when the library is loaded.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+__attribute__((constructor)) static void register_fork_handlers(void)
+{
+    pthread_atfork(mem_fork_prepare, mem_fork_parent, mem_fork_child);
+}
+
+/* libc returns a unique pointer for zero-byte requests and sets errno */
+static void* checked(void *ptr)
+{
+    if (ptr == NULL) {
+        errno = ENOMEM;
+    }
+    return ptr;
+}
+
+void* malloc(size_t size)
+{
+    return checked(mem_malloc(size != 0 ? size : 1));
+}
+
+void free(void *ptr)
+{
+    mem_free(ptr);
+}
+
+void* calloc(size_t nmemb, size_t size)
+{
+    return nmemb == 0 || size == 0 ? malloc(1) : checked(mem_calloc(nmemb, size));
+}
+
+void* realloc(void *ptr, size_t size)
+{
+    if (ptr != NULL && size == 0) {
+        mem_free(ptr);
+        return NULL;
+    }
+    return checked(mem_realloc(ptr, size != 0 ? size : 1));
+}
+
+void* reallocarray(void *ptr, size_t nmemb, size_t size)
+{
+    if (nmemb != 0 && size > SIZE_MAX / nmemb) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr, nmemb * size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    return mem_posix_memalign(memptr, alignment, size != 0 ? size : 1);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return checked(mem_aligned_alloc(alignment, size != 0 ? size : 1));
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return checked(mem_memalign(alignment, size != 0 ? size : 1));
+}
+
+void* valloc(size_t size)
+{
+    return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+/* Rounding up to whole pages must not wrap */
+void* pvalloc(size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    
+    if (size > SIZE_MAX - page) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return memalign(page, mem_page_align(size != 0 ? size : 1));
+}
+
+size_t malloc_usable_size(void *ptr)
+{
+    return ptr != NULL ? mem_get_block_size(ptr) : 0;
+}
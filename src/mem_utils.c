@@ -12,6 +12,11 @@
  * - mem_splitting.c: Block splitting operations
  * - mem_merging.c: Block merging operations  
  * - mem_validation.c: Pointer validation and conversion
+ * - mem_page_map.c: Radix map from pages to heaps, tiny runs and mappings
+ * - mem_bins.c: Segregated size-class free lists
+ * - mem_size_tree.c: Size-ordered treap of large free blocks
+ * - mem_boundary_tags.c: Implicit list navigation and footers
+ * - mem_purging.c: Clean/dirty state of free blocks and page purging
  * 
  * ============================================================================
  */
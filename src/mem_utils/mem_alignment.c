@@ -3,34 +3,54 @@
  * MEMORY ALLOCATOR - Memory Alignment and Block Finding
  * ============================================================================
  * 
- * This file implements memory alignment calculations and free block
- * finding functions for the memory allocator.
+ * This file implements memory and page alignment calculations and free block
+ * finding functions for the memory allocator. Free blocks are looked up
+ * through the segregated bins and the size tree, so the search never
+ * visits allocated blocks. Large requests, and small ones whose bins are
+ * all empty, take the best fit from the tree.
  * 
  * ============================================================================
  */
 
 #include "../../include/mem_alloc.h"
 #include "../../include/mem_utils.h"
+#include <unistd.h>
 
 size_t mem_align_size(size_t size)
 {
-    if (size < MEM_MIN_BLOCK_SIZE) {
-        size = MEM_MIN_BLOCK_SIZE;
-    }
+    size_t chunk = (size + MEM_HEADER_SIZE + MEM_ALIGNMENT - 1) & ~(size_t)(MEM_ALIGNMENT - 1);
     
-    return (size + MEM_ALIGNMENT - 1) & ~(MEM_ALIGNMENT - 1);
+    size = chunk - MEM_HEADER_SIZE;
+    return size < MEM_MIN_BLOCK_SIZE ? MEM_MIN_BLOCK_SIZE : size;
 }
 
-mem_block_t* mem_find_free_block(size_t size)
+size_t mem_page_align(size_t size)
 {
-    mem_block_t *current = first_block;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
     
-    while (current != NULL) {
-        if (current->is_free && current->size >= size) {
-            return current;
+    return (size + page - 1) & ~(page - 1);
+}
+
+static size_t next_nonempty_bin(mem_heap_t *heap, size_t index)
+{
+    while (index < MEM_NUM_BINS) {
+        uint64_t word = heap->bin_bitmap[index / 64] & (~0ULL << (index % 64));
+        if (word != 0) {
+            return (index & ~(size_t)63) + (size_t)__builtin_ctzll(word);
         }
-        current = current->next;
+        index = (index & ~(size_t)63) + 64;
     }
     
-    return NULL;
+    return MEM_NUM_BINS;
+}
+
+mem_block_t* mem_find_free_block(mem_heap_t *heap, size_t size)
+{
+    if (size < MEM_SMALL_BIN_LIMIT) {
+        size_t index = next_nonempty_bin(heap, mem_bin_index(size));
+        if (index < MEM_NUM_BINS) {
+            return heap->free_bins[index];
+        }
+    }
+    return mem_tree_best_fit(heap->large_tree, size);
 }
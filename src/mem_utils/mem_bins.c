@@ -0,0 +1,112 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Segregated Free Lists
+ * ============================================================================
+ * 
+ * This file implements the size-class bins that index every free block.
+ * Small sizes get one exact bin per alignment step, and a bitmap of
+ * non-empty bins lets the allocator jump straight to a fitting bin.
+ * Larger sizes go to the heap's size tree instead. Since every free block
+ * passes through here, the bins also keep the heap's free byte, free
+ * block and dirty byte totals and its histogram of free block sizes; a
+ * binned block never changes size or clean state without leaving its bin.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+static mem_free_node_t* free_node(mem_block_t *block)
+{
+    return (mem_free_node_t*)mem_block_to_ptr(block);
+}
+
+static void count_free(mem_heap_t *heap, mem_block_t *block)
+{
+    size_t size = mem_block_size(block);
+    
+    heap->free_bytes += size;
+    heap->free_blocks++;
+    heap->dirty_bytes += (block->header & MEM_BLOCK_CLEAN) ? 0 : size;
+    heap->free_histogram[mem_stats_class(size)]++;
+}
+
+static void uncount_free(mem_heap_t *heap, mem_block_t *block)
+{
+    size_t size = mem_block_size(block);
+    
+    heap->free_bytes -= size;
+    heap->free_blocks--;
+    heap->dirty_bytes -= (block->header & MEM_BLOCK_CLEAN) ? 0 : size;
+    heap->free_histogram[mem_stats_class(size)]--;
+}
+
+/* Only meaningful for sizes below MEM_SMALL_BIN_LIMIT */
+size_t mem_bin_index(size_t size)
+{
+    return (size - MEM_MIN_BLOCK_SIZE) / MEM_ALIGNMENT;
+}
+
+void mem_bin_insert(mem_heap_t *heap, mem_block_t *block)
+{
+    size_t index = mem_bin_index(mem_block_size(block));
+    mem_free_node_t *node = free_node(block);
+    
+    count_free(heap, block);
+    if (mem_block_size(block) >= MEM_SMALL_BIN_LIMIT) {
+        mem_tree_insert(&heap->large_tree, block);
+        return;
+    }
+    
+    node->prev_free = NULL;
+    node->next_free = heap->free_bins[index];
+    if (heap->free_bins[index] != NULL) {
+        free_node(heap->free_bins[index])->prev_free = block;
+    }
+    
+    heap->free_bins[index] = block;
+    heap->bin_bitmap[index / 64] |= 1ULL << (index % 64);
+}
+
+void mem_bin_remove(mem_heap_t *heap, mem_block_t *block)
+{
+    size_t index = mem_bin_index(mem_block_size(block));
+    mem_free_node_t *node = free_node(block);
+    
+    uncount_free(heap, block);
+    if (mem_block_size(block) >= MEM_SMALL_BIN_LIMIT) {
+        mem_tree_remove(&heap->large_tree, block);
+        return;
+    }
+    
+    if (node->prev_free != NULL) {
+        free_node(node->prev_free)->next_free = node->next_free;
+    } else {
+        heap->free_bins[index] = node->next_free;
+    }
+    if (node->next_free != NULL) {
+        free_node(node->next_free)->prev_free = node->prev_free;
+    }
+    
+    if (heap->free_bins[index] == NULL) {
+        heap->bin_bitmap[index / 64] &= ~(1ULL << (index % 64));
+    }
+}
+
+void mem_bins_reset(mem_heap_t *heap)
+{
+    for (size_t i = 0; i < MEM_NUM_BINS; i++) {
+        heap->free_bins[i] = NULL;
+    }
+    for (size_t i = 0; i < MEM_BITMAP_WORDS; i++) {
+        heap->bin_bitmap[i] = 0;
+    }
+    heap->large_tree = NULL;
+    heap->free_bytes = 0;
+    heap->free_blocks = 0;
+    heap->dirty_bytes = 0;
+    for (size_t i = 0; i < MEM_STATS_CLASSES; i++) {
+        heap->free_histogram[i] = 0;
+    }
+}
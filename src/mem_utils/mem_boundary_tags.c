@@ -0,0 +1,49 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Boundary Tags
+ * ============================================================================
+ * 
+ * This file implements navigation over the implicit block list and the
+ * bookkeeping that keeps headers, footers and the prev-free bit of the
+ * following block consistent whenever a block changes state. The
+ * following block may be allocated and inspected by a lock-free free
+ * path, so its bit is flipped atomically.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+mem_block_t* mem_next_block(mem_block_t *block)
+{
+    mem_block_t *next = mem_block_successor(block);
+    
+    if (mem_block_size(next) == 0) {
+        return NULL;
+    }
+    return next;
+}
+
+mem_block_t* mem_prev_free_block(mem_block_t *block)
+{
+    if (!mem_block_is_prev_free(block)) {
+        return NULL;
+    }
+    
+    size_t prev_size = *((size_t*)block - 1);
+    return (mem_block_t*)((char*)block - prev_size - MEM_HEADER_SIZE);
+}
+
+void mem_block_mark_free(mem_block_t *block)
+{
+    block->header |= MEM_BLOCK_FREE;
+    *mem_block_footer(block) = mem_block_size(block);
+    __atomic_fetch_or(&mem_block_successor(block)->header, MEM_BLOCK_PREV_FREE, __ATOMIC_RELAXED);
+}
+
+void mem_block_mark_used(mem_block_t *block)
+{
+    block->header &= ~(MEM_BLOCK_FREE | MEM_BLOCK_CLEAN);
+    __atomic_fetch_and(&mem_block_successor(block)->header, ~MEM_BLOCK_PREV_FREE, __ATOMIC_RELAXED);
+}
@@ -4,7 +4,11 @@
  * ============================================================================
  * 
  * This file implements block merging operations for the memory allocator.
- * Combines adjacent free blocks to reduce fragmentation.
+ * Combines adjacent free blocks to reduce fragmentation. The block passed
+ * in must be marked free but not binned yet; the merged result is filed
+ * into its bin. Both directions are O(1) thanks to the boundary tags.
+ * The merged block is clean only if both parts were, and otherwise dirty
+ * since the older of the two.
  * 
  * ============================================================================
  */
@@ -12,36 +16,43 @@
 #include "../../include/mem_alloc.h"
 #include "../../include/mem_utils.h"
 
-static void merge_with_next(mem_block_t *block)
+static void absorb_block(mem_heap_t *heap, mem_block_t *block, mem_block_t *absorbed)
 {
-    if (block->next != NULL && block->next->is_free) {
-        block->size += sizeof(mem_block_t) + block->next->size;
-        
-        if (block->next->next != NULL) {
-            block->next->next->prev = block;
-        }
-        
-        block->next = block->next->next;
-        global_stats.num_blocks--;
+    size_t size = mem_block_size(block) + MEM_HEADER_SIZE + mem_block_size(absorbed);
+    uint64_t since = mem_purge_merged_since(block, absorbed);
+    
+    mem_block_set_size(block, size);
+    *mem_block_footer(block) = mem_block_size(block);
+    mem_block_set_dirty_since(block, since);
+    heap->num_blocks--;
+}
+
+static void merge_with_next(mem_heap_t *heap, mem_block_t *block)
+{
+    mem_block_t *next = mem_next_block(block);
+    
+    if (next != NULL && mem_block_is_free(next)) {
+        mem_bin_remove(heap, next);
+        absorb_block(heap, block, next);
     }
 }
 
-static void merge_with_prev(mem_block_t *block)
+static mem_block_t* merge_with_prev(mem_heap_t *heap, mem_block_t *block)
 {
-    if (block->prev != NULL && block->prev->is_free) {
-        block->prev->size += sizeof(mem_block_t) + block->size;
-        
-        if (block->next != NULL) {
-            block->next->prev = block->prev;
-        }
-        
-        block->prev->next = block->next;
-        global_stats.num_blocks--;
+    mem_block_t *prev = mem_prev_free_block(block);
+    
+    if (prev != NULL) {
+        mem_bin_remove(heap, prev);
+        absorb_block(heap, prev, block);
+        return prev;
     }
+    return block;
 }
 
-void mem_merge_blocks(mem_block_t *block)
+mem_block_t* mem_merge_blocks(mem_heap_t *heap, mem_block_t *block)
 {
-    merge_with_next(block);
-    merge_with_prev(block);
+    merge_with_next(heap, block);
+    block = merge_with_prev(heap, block);
+    mem_bin_insert(heap, block);
+    return block;
 }
@@ -0,0 +1,98 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Page Map
+ * ============================================================================
+ * 
+ * This file implements the radix map from page numbers to page owners.
+ * The root is a static array of leaf pointers; a leaf is mapped with
+ * MAP_NORESERVE the first time a page in its range is registered, and
+ * is installed with a compare-and-swap so concurrent registrations need
+ * no lock. Entries are read and written atomically. Leaves stay mapped
+ * for the life of the process, so a lookup is two loads and never
+ * faults, whatever pointer it is given.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <sys/mman.h>
+
+#define LEAF_ENTRIES    ((size_t)1 << MEM_PAGE_MAP_LEAF_BITS)
+#define LEAF_MASK       (LEAF_ENTRIES - 1)
+
+static uintptr_t *page_map_root[MEM_PAGE_MAP_ROOT_SIZE];
+
+static bool page_in_range(uintptr_t page)
+{
+    return page < ((uintptr_t)1 << MEM_PAGE_MAP_BITS);
+}
+
+static uintptr_t* create_leaf(uintptr_t **slot)
+{
+    uintptr_t *expected = NULL;
+    uintptr_t *leaf = mmap(NULL, LEAF_ENTRIES * sizeof(uintptr_t), PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    
+    if (leaf == MAP_FAILED) {
+        return NULL;
+    }
+    if (!__atomic_compare_exchange_n(slot, &expected, leaf, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        munmap(leaf, LEAF_ENTRIES * sizeof(uintptr_t));
+        return expected;
+    }
+    return leaf;
+}
+
+static uintptr_t* leaf_for(uintptr_t page, bool create)
+{
+    uintptr_t **slot = &page_map_root[page >> MEM_PAGE_MAP_LEAF_BITS];
+    uintptr_t *leaf = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    
+    return leaf != NULL || !create ? leaf : create_leaf(slot);
+}
+
+static int store_range(void *start, size_t length, uintptr_t entry)
+{
+    uintptr_t first = (uintptr_t)start >> MEM_PAGE_SHIFT;
+    uintptr_t last = ((uintptr_t)start + length - 1) >> MEM_PAGE_SHIFT;
+    
+    for (uintptr_t page = first; page <= last; page++) {
+        uintptr_t *leaf = page_in_range(page) ? leaf_for(page, entry != 0) : NULL;
+        if (leaf == NULL) {
+            if (entry != 0) {
+                return -1;
+            }
+            continue;
+        }
+        __atomic_store_n(&leaf[page & LEAF_MASK], entry, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+int mem_page_map_set(void *start, size_t length, mem_page_kind_t kind, void *owner)
+{
+    if (store_range(start, length, (uintptr_t)owner | (uintptr_t)kind) != 0) {
+        mem_page_map_clear(start, length);
+        return -1;
+    }
+    return 0;
+}
+
+void mem_page_map_clear(void *start, size_t length)
+{
+    store_range(start, length, 0);
+}
+
+mem_page_kind_t mem_page_map_lookup(const void *ptr, void **owner)
+{
+    uintptr_t page = (uintptr_t)ptr >> MEM_PAGE_SHIFT;
+    uintptr_t *leaf = page_in_range(page) ? leaf_for(page, false) : NULL;
+    uintptr_t entry = leaf != NULL ? __atomic_load_n(&leaf[page & LEAF_MASK], __ATOMIC_ACQUIRE) : 0;
+    
+    if (owner != NULL) {
+        *owner = (void*)(entry & ~MEM_PAGE_KIND_MASK);
+    }
+    return (mem_page_kind_t)(entry & MEM_PAGE_KIND_MASK);
+}
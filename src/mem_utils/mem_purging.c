@@ -0,0 +1,87 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Page Purging
+ * ============================================================================
+ * 
+ * This file implements the per-block side of page purging: the clean and
+ * dirty-since state of free blocks, how that state survives splitting and
+ * merging, and returning the whole pages inside a dirty free block to
+ * the OS. Purged interiors read back as zero, and the partial pages at
+ * both ends are zeroed by hand, so a purged block is clean.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+#include <sys/mman.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static mem_purge_node_t* purge_node(mem_block_t *block)
+{
+    return (mem_purge_node_t*)mem_block_to_ptr(block);
+}
+
+uint64_t mem_clock_ms(void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+uint64_t mem_block_dirty_since(mem_block_t *block)
+{
+    if (block->header & MEM_BLOCK_CLEAN) {
+        return MEM_PURGE_CLEAN;
+    }
+    if (mem_block_size(block) < MEM_PURGE_MIN_SIZE) {
+        return mem_clock_ms();
+    }
+    return purge_node(block)->dirty_since;
+}
+
+void mem_block_set_dirty_since(mem_block_t *block, uint64_t since)
+{
+    if (since == MEM_PURGE_CLEAN) {
+        block->header |= MEM_BLOCK_CLEAN;
+        return;
+    }
+    
+    block->header &= ~MEM_BLOCK_CLEAN;
+    if (mem_block_size(block) >= MEM_PURGE_MIN_SIZE) {
+        purge_node(block)->dirty_since = since;
+    }
+}
+
+/* Called before next is absorbed; zeroes the seam if both sides are clean */
+uint64_t mem_purge_merged_since(mem_block_t *block, mem_block_t *next)
+{
+    uint64_t since = mem_block_dirty_since(block);
+    uint64_t next_since = mem_block_dirty_since(next);
+    
+    if (since == MEM_PURGE_CLEAN && next_since == MEM_PURGE_CLEAN) {
+        memset(mem_block_footer(block), 0, MEM_FOOTER_SIZE + MEM_HEADER_SIZE + MEM_CLEAN_OFFSET);
+    }
+    return since < next_since ? since : next_since;
+}
+
+size_t mem_purge_block(mem_block_t *block)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char *start = (char*)mem_block_to_ptr(block) + MEM_CLEAN_OFFSET;
+    char *end = (char*)mem_block_footer(block);
+    char *low = (char*)(((uintptr_t)start + page - 1) & ~(uintptr_t)(page - 1));
+    char *high = (char*)((uintptr_t)end & ~(uintptr_t)(page - 1));
+    
+    if (high <= low || madvise(low, (size_t)(high - low), MADV_DONTNEED) != 0) {
+        return 0;
+    }
+    
+    memset(start, 0, (size_t)(low - start));
+    memset(high, 0, (size_t)(end - high));
+    mem_block_set_dirty_since(block, MEM_PURGE_CLEAN);
+    return (size_t)(high - low);
+}
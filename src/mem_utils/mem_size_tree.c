@@ -0,0 +1,155 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Size Tree
+ * ============================================================================
+ * 
+ * This file implements the best-fit index for free blocks too large for
+ * the small bins: a treap ordered by (size, address). The links reuse the
+ * two words a binned block keeps for its list, and a block's priority is
+ * a hash of its address, so nodes need no extra space and the tree stays
+ * balanced in expectation without any rebalancing state. Lookups return
+ * the smallest block that fits, lowest address first among equal sizes.
+ * 
+ * ============================================================================
+ */
+
+#include "../../include/mem_alloc.h"
+#include "../../include/mem_utils.h"
+
+static mem_tree_node_t* tree_node(mem_block_t *block)
+{
+    return (mem_tree_node_t*)mem_block_to_ptr(block);
+}
+
+static uint64_t priority(mem_block_t *block)
+{
+    uint64_t key = (uint64_t)(uintptr_t)block;
+    
+    key = (key ^ (key >> 33)) * 0xFF51AFD7ED558CCDULL;
+    return key ^ (key >> 33);
+}
+
+static bool key_less(mem_block_t *block, mem_block_t *other)
+{
+    size_t size = mem_block_size(block);
+    size_t other_size = mem_block_size(other);
+    
+    return size < other_size || (size == other_size && block < other);
+}
+
+static mem_block_t* rotate_right(mem_block_t *root)
+{
+    mem_block_t *left = tree_node(root)->left;
+    
+    tree_node(root)->left = tree_node(left)->right;
+    tree_node(left)->right = root;
+    return left;
+}
+
+static mem_block_t* rotate_left(mem_block_t *root)
+{
+    mem_block_t *right = tree_node(root)->right;
+    
+    tree_node(root)->right = tree_node(right)->left;
+    tree_node(right)->left = root;
+    return right;
+}
+
+static mem_block_t* insert(mem_block_t *root, mem_block_t *block)
+{
+    if (root == NULL) {
+        return block;
+    }
+    
+    if (key_less(block, root)) {
+        tree_node(root)->left = insert(tree_node(root)->left, block);
+        if (priority(tree_node(root)->left) > priority(root)) {
+            root = rotate_right(root);
+        }
+    } else {
+        tree_node(root)->right = insert(tree_node(root)->right, block);
+        if (priority(tree_node(root)->right) > priority(root)) {
+            root = rotate_left(root);
+        }
+    }
+    return root;
+}
+
+/* Joins two treaps whose keys are all ordered left before right */
+static mem_block_t* join(mem_block_t *left, mem_block_t *right)
+{
+    if (left == NULL || right == NULL) {
+        return left != NULL ? left : right;
+    }
+    
+    if (priority(left) > priority(right)) {
+        tree_node(left)->right = join(tree_node(left)->right, right);
+        return left;
+    }
+    tree_node(right)->left = join(left, tree_node(right)->left);
+    return right;
+}
+
+static mem_block_t* remove_block(mem_block_t *root, mem_block_t *block)
+{
+    if (root == NULL) {
+        return NULL;
+    }
+    if (root == block) {
+        return join(tree_node(block)->left, tree_node(block)->right);
+    }
+    
+    if (key_less(block, root)) {
+        tree_node(root)->left = remove_block(tree_node(root)->left, block);
+    } else {
+        tree_node(root)->right = remove_block(tree_node(root)->right, block);
+    }
+    return root;
+}
+
+void mem_tree_insert(mem_block_t **root, mem_block_t *block)
+{
+    tree_node(block)->left = NULL;
+    tree_node(block)->right = NULL;
+    *root = insert(*root, block);
+}
+
+void mem_tree_remove(mem_block_t **root, mem_block_t *block)
+{
+    *root = remove_block(*root, block);
+}
+
+mem_block_t* mem_tree_best_fit(mem_block_t *root, size_t size)
+{
+    mem_block_t *best = NULL;
+    
+    while (root != NULL) {
+        if (mem_block_size(root) >= size) {
+            best = root;
+            root = tree_node(root)->left;
+        } else {
+            root = tree_node(root)->right;
+        }
+    }
+    return best;
+}
+
+mem_block_t* mem_tree_largest(mem_block_t *root)
+{
+    while (root != NULL && tree_node(root)->right != NULL) {
+        root = tree_node(root)->right;
+    }
+    return root;
+}
+
+/* In-order walk; visit may change a block's state but not its size */
+void mem_tree_for_each(mem_block_t *root, void (*visit)(mem_block_t *block, void *arg), void *arg)
+{
+    if (root == NULL) {
+        return;
+    }
+    
+    mem_tree_for_each(tree_node(root)->left, visit, arg);
+    visit(root, arg);
+    mem_tree_for_each(tree_node(root)->right, visit, arg);
+}
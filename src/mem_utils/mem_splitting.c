@@ -5,6 +5,10 @@
  * 
  * This file implements block splitting operations for the memory allocator.
  * Handles dividing large blocks into smaller allocated and free sections.
+ * The free remainder is filed into its size-class bin and keeps the purge
+ * state of a free original; the tail of an allocated block is dirty.
+ * Batch allocations carve a whole row of equal blocks from one free
+ * block, touching the bins once for the remainder.
  * 
  * ============================================================================
  */
@@ -14,31 +18,64 @@
 
 static void setup_new_block(mem_block_t *new_block, mem_block_t *block, size_t remaining_size)
 {
-    new_block->size = remaining_size;
-    new_block->is_free = true;
-    new_block->magic = MEM_MAGIC_FREE;
-    new_block->next = block->next;
-    new_block->prev = block;
-    
-    if (block->next != NULL) {
-        block->next->prev = new_block;
+    new_block->header = remaining_size;
+    if (mem_block_is_free(block)) {
+        new_block->header |= MEM_BLOCK_PREV_FREE;
+        *mem_block_footer(block) = mem_block_size(block);
     }
     
-    block->next = new_block;
+    mem_block_mark_free(new_block);
 }
 
-mem_block_t* mem_split_block(mem_block_t *block, size_t size)
+mem_block_t* mem_split_block(mem_heap_t *heap, mem_block_t *block, size_t size)
 {
-    if (block->size <= size + sizeof(mem_block_t)) {
+    size_t block_size = mem_block_size(block);
+    
+    if (block_size < size + MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE) {
         return NULL;
     }
     
-    mem_block_t *new_block = (mem_block_t*)((char*)block + sizeof(mem_block_t) + size);
-    size_t remaining_size = block->size - size - sizeof(mem_block_t);
+    mem_block_t *new_block = (mem_block_t*)((char*)block + MEM_HEADER_SIZE + size);
+    size_t remaining_size = block_size - size - MEM_HEADER_SIZE;
+    uint64_t since = mem_block_is_free(block) ? mem_block_dirty_since(block) : mem_clock_ms();
     
+    mem_block_set_size(block, size);
     setup_new_block(new_block, block, remaining_size);
-    block->size = size;
-    global_stats.num_blocks++;
+    mem_block_set_dirty_since(new_block, since);
+    heap->num_blocks++;
+    mem_bin_insert(heap, new_block);
     
     return new_block;
 }
+
+/* Lays used blocks end to end from the front of a free block already out of the bins */
+size_t mem_carve_blocks(mem_heap_t *heap, mem_block_t *block, size_t size, void **ptrs, size_t count)
+{
+    size_t stride = size + MEM_HEADER_SIZE;
+    size_t span = mem_block_size(block) + MEM_HEADER_SIZE;
+    size_t carved = span / stride < count ? span / stride : count;
+    size_t rest = span - carved * stride;
+    uint64_t since = mem_block_dirty_since(block);
+    
+    for (size_t i = 0; i < carved; i++) {
+        mem_block_t *carved_block = (mem_block_t*)((char*)block + i * stride);
+        carved_block->header = size;
+        ptrs[i] = mem_block_to_ptr(carved_block);
+    }
+    
+    mem_block_t *last = mem_ptr_to_block(ptrs[carved - 1]);
+    if (rest < MEM_HEADER_SIZE + MEM_MIN_BLOCK_SIZE) {
+        mem_block_set_size(last, size + rest);
+        mem_block_mark_used(last);
+        heap->num_blocks += carved - 1;
+        return carved;
+    }
+    
+    mem_block_t *tail = mem_block_successor(last);
+    tail->header = rest - MEM_HEADER_SIZE;
+    mem_block_mark_free(tail);
+    mem_block_set_dirty_since(tail, since);
+    heap->num_blocks += carved;
+    mem_bin_insert(heap, tail);
+    return carved;
+}
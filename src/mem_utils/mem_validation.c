@@ -4,7 +4,12 @@
  * ============================================================================
  * 
  * This file implements pointer validation and conversion functions
- * between user pointers and memory blocks.
+ * between user pointers and memory blocks. Without a magic number the
+ * header is validated structurally: alignment, minimum size and a block
+ * end that stays in front of the epilogue of the owning heap. The check
+ * only reads the header, so it is safe without the heap lock. Callers
+ * find the heap through the page map first, so the header read always
+ * lands in committed heap memory.
  * 
  * ============================================================================
  */
@@ -12,28 +17,36 @@
 #include "../../include/mem_alloc.h"
 #include "../../include/mem_utils.h"
 
-static bool is_ptr_in_heap_bounds(void *ptr)
+static bool is_ptr_in_heap_bounds(mem_heap_t *heap, void *ptr)
 {
-    return ptr >= heap_start && ptr < heap_end;
+    return ptr >= (void*)mem_block_to_ptr(heap->first_block)
+        && ptr < __atomic_load_n(&heap->end, __ATOMIC_ACQUIRE);
 }
 
-static bool is_block_valid(mem_block_t *block)
+static bool is_block_valid(mem_heap_t *heap, mem_block_t *block)
 {
-    if ((void*)block < heap_start || (void*)block >= heap_end) {
+    size_t size = __atomic_load_n(&block->header, __ATOMIC_RELAXED) & ~MEM_BLOCK_FLAGS;
+    char *block_end = (char*)mem_block_to_ptr(block) + size;
+    
+    if (size < MEM_MIN_BLOCK_SIZE || (size + MEM_HEADER_SIZE) % MEM_ALIGNMENT != 0) {
         return false;
     }
     
-    return (block->magic == MEM_MAGIC_ALLOCATED || block->magic == MEM_MAGIC_FREE);
+    return block_end <= (char*)__atomic_load_n(&heap->end, __ATOMIC_ACQUIRE) - MEM_HEADER_SIZE;
 }
 
-bool mem_is_valid_ptr(void *ptr)
+bool mem_is_valid_ptr(mem_heap_t *heap, void *ptr)
 {
-    if (ptr == NULL || !is_ptr_in_heap_bounds(ptr)) {
+    if (ptr == NULL || heap == NULL || !is_ptr_in_heap_bounds(heap, ptr)) {
+        return false;
+    }
+    
+    if ((uintptr_t)ptr % MEM_ALIGNMENT != 0) {
         return false;
     }
     
     mem_block_t *block = mem_ptr_to_block(ptr);
-    return is_block_valid(block);
+    return is_block_valid(heap, block);
 }
 
 void* mem_block_to_ptr(mem_block_t *block)
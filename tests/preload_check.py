@@ -0,0 +1,88 @@
+"""Exercise the allocator from a real interpreter run under LD_PRELOAD.
+
+Covers small and large objects, many threads, realloc-heavy string
+building, requests too large to serve, fork from a threaded process and
+subprocesses.
+"""
+import ctypes
+import errno
+import os
+import subprocess
+import sys
+import threading
+
+libc = ctypes.CDLL(None, use_errno=True)
+libc.malloc_usable_size.restype = ctypes.c_size_t
+libc.malloc_usable_size.argtypes = [ctypes.c_void_p]
+libc.malloc.restype = ctypes.c_void_p
+libc.malloc.argtypes = [ctypes.c_size_t]
+libc.calloc.restype = ctypes.c_void_p
+libc.calloc.argtypes = [ctypes.c_size_t, ctypes.c_size_t]
+libc.realloc.restype = ctypes.c_void_p
+libc.realloc.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+libc.pvalloc.restype = ctypes.c_void_p
+libc.pvalloc.argtypes = [ctypes.c_size_t]
+libc.free.argtypes = [ctypes.c_void_p]
+
+SIZE_MAX = ctypes.c_size_t(-1).value
+
+
+def churn(seed, results):
+    data = {}
+    for i in range(20000):
+        key = (seed * 7919 + i * 104729) % 5000
+        data[key] = "x" * (key % 700) + str(i)
+        if i % 3 == 0:
+            data.pop((key * 31) % 5000, None)
+    blob = b"".join(str(k).encode() * 50 for k in range(2000))
+    results[seed] = len(data) + len(blob)
+
+
+def expect_enomem(name, call):
+    ctypes.set_errno(0)
+    ptr = call()
+    error = ctypes.get_errno()
+    assert ptr is None, "%s returned a block" % name
+    assert error == errno.ENOMEM, "%s set errno %d" % (name, error)
+
+
+def check_huge_requests():
+    expect_enomem("malloc(SIZE_MAX)", lambda: libc.malloc(SIZE_MAX))
+    expect_enomem("malloc(SIZE_MAX - 7)", lambda: libc.malloc(SIZE_MAX - 7))
+    expect_enomem("calloc(1, SIZE_MAX - 7)", lambda: libc.calloc(1, SIZE_MAX - 7))
+    expect_enomem("pvalloc(SIZE_MAX - 100)", lambda: libc.pvalloc(SIZE_MAX - 100))
+
+    ptr = libc.malloc(1000)
+    ctypes.memset(ptr, 0x5A, 1000)
+    expect_enomem("realloc(p, SIZE_MAX)", lambda: libc.realloc(ptr, SIZE_MAX))
+    assert ctypes.string_at(ptr, 1000) == b"\x5a" * 1000, "failed realloc lost the contents"
+    libc.free(ptr)
+
+
+def main():
+    results = {}
+    threads = [threading.Thread(target=churn, args=(n, results)) for n in range(8)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert len(results) == 8
+
+    ptr = libc.malloc(1000)
+    assert libc.malloc_usable_size(ptr) >= 1000
+    libc.free(ptr)
+    check_huge_requests()
+
+    pid = os.fork()
+    if pid == 0:
+        os._exit(0 if sum(len(str(n)) for n in range(100000)) > 0 else 1)
+    _, status = os.waitpid(pid, 0)
+    assert status == 0, "forked child failed"
+
+    out = subprocess.run(["sort"], input=b"b\na\nc\n", capture_output=True, check=True)
+    assert out.stdout == b"a\nb\nc\n"
+    print("python3: %d threads, fork and subprocess ok" % len(threads))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -15,6 +15,7 @@
  * - Error conditions and edge cases
  * - Memory leak detection
  * - Statistics and integrity checking
+ * - Multi-threaded contention
  * 
  * ============================================================================
  */
@@ -23,8 +24,20 @@
 #include <criterion/redirect.h>
 #include "../include/mem_alloc.h"
 #include "../include/mem_utils.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define STRESS_THREADS      8
+#define STRESS_OPERATIONS   20000
+#define STRESS_SLOTS        64
 
 static void setup(void);
+static void setup_per_cpu(void);
 static void teardown(void);
 
 static void setup(void)
@@ -33,6 +46,15 @@ static void setup(void)
     mem_init(MEM_HEAP_SIZE);
 }
 
+static void setup_per_cpu(void)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    
+    config.cache_mode = MEM_CACHE_PER_CPU;
+    mem_cleanup();
+    mem_init_config(&config);
+}
+
 static void teardown(void)
 {
     mem_cleanup();
@@ -42,6 +64,8 @@ TestSuite(basic_allocation, .init = setup, .fini = teardown);
 TestSuite(advanced_features, .init = setup, .fini = teardown);
 TestSuite(error_handling, .init = setup, .fini = teardown);
 TestSuite(statistics, .init = setup, .fini = teardown);
+TestSuite(concurrency, .init = setup, .fini = teardown);
+TestSuite(per_cpu_cache, .init = setup_per_cpu, .fini = teardown);
 
 Test(basic_allocation, malloc_free_basic)
 {
@@ -61,6 +85,12 @@ Test(basic_allocation, malloc_zero_size)
     cr_assert_null(ptr, "malloc(0) should return NULL");
 }
 
+Test(basic_allocation, malloc_huge_size)
+{
+    cr_assert_null(mem_malloc(SIZE_MAX), "malloc(SIZE_MAX) should return NULL");
+    cr_assert_null(mem_malloc((size_t)PTRDIFF_MAX + 1), "malloc past PTRDIFF_MAX should return NULL");
+}
+
 Test(basic_allocation, free_null_pointer)
 {
     mem_free(NULL);
@@ -113,6 +143,222 @@ Test(basic_allocation, calloc_basic)
     mem_free(ptr);
 }
 
+Test(basic_allocation, aligned_alloc_basic)
+{
+    size_t alignments[] = {16, 64, 4096, 64 * 1024};
+    
+    for (size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); i++) {
+        char *ptr = mem_aligned_alloc(alignments[i], 100);
+        cr_assert_not_null(ptr, "Aligned allocation should succeed");
+        cr_assert_eq((uintptr_t)ptr % alignments[i], 0, "Pointer should be aligned");
+        memset(ptr, 'x', 100);
+        mem_free(ptr);
+    }
+    cr_assert_null(mem_aligned_alloc(48, 100), "Alignment must be a power of two");
+    cr_assert(mem_check_integrity(), "Heap should be valid after aligned allocations");
+}
+
+Test(basic_allocation, posix_memalign_basic)
+{
+    void *ptr = NULL;
+    
+    cr_assert_eq(mem_posix_memalign(&ptr, 256, 1000), 0, "posix_memalign should succeed");
+    cr_assert_eq((uintptr_t)ptr % 256, 0, "Pointer should be aligned");
+    mem_free(ptr);
+    
+    cr_assert_eq(mem_posix_memalign(&ptr, 4, 1000), EINVAL, "Alignment below a pointer is invalid");
+    cr_assert_eq(mem_posix_memalign(&ptr, 96, 1000), EINVAL, "Alignment must be a power of two");
+}
+
+Test(advanced_features, aligned_alloc_keeps_leading_gap)
+{
+    mem_stats_t stats;
+    char *aligned = mem_aligned_alloc(4096, 2048);
+    char *before = mem_malloc(1024);
+    
+    cr_assert(before < aligned, "Gap in front of an aligned block should be reused");
+    
+    mem_free(before);
+    mem_free(aligned);
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "Aligned blocks should free completely");
+    cr_assert(mem_check_integrity(), "Heap should be valid after reusing the gap");
+}
+
+Test(advanced_features, large_aligned_alloc_is_mapped)
+{
+    static const size_t alignments[] = { 64, 4096, 65536, (size_t)1 << 21 };
+    size_t size = MEM_MMAP_THRESHOLD * 3 + 100;
+    size_t mappings = mem_mmap_count();
+    mem_stats_t stats;
+    
+    for (size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); i++) {
+        char *ptr = mem_aligned_alloc(alignments[i], size);
+        cr_assert_not_null(ptr, "Large aligned allocation should succeed");
+        cr_assert_eq((uintptr_t)ptr % alignments[i], 0, "Large aligned allocation should honour the alignment");
+        cr_assert_eq(mem_mmap_count(), mappings + 1, "Large aligned allocation should get its own mapping");
+        cr_assert_geq(mem_get_block_size(ptr), size, "Mapping should hold the request");
+        memset(ptr, 0x6B, size);
+        
+        ptr = mem_realloc(ptr, size * 2);
+        cr_assert_not_null(ptr, "Aligned mapping should remap");
+        cr_assert_eq(ptr[size - 1], 0x6B, "Remapping should keep the contents");
+        mem_free(ptr);
+        cr_assert_eq(mem_mmap_count(), mappings, "Freeing should unmap the aligned mapping");
+    }
+    
+    void *huge = NULL;
+    cr_assert_eq(mem_posix_memalign(&huge, 4096, (size_t)3 << 30), 0, "Aligned requests past a heap should be mapped");
+    cr_assert_eq((uintptr_t)huge % 4096, 0, "Huge aligned allocation should honour the alignment");
+    mem_free(huge);
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "Aligned mappings should free completely");
+    cr_assert(mem_check_integrity(), "Heap should be valid after aligned mappings");
+}
+
+Test(advanced_features, pool_alloc_free)
+{
+    mem_pool_t *pool = mem_pool_create(40, 64);
+    void *objects[100];
+    mem_pool_stats_t stats;
+    
+    cr_assert_not_null(pool, "Pool creation should succeed");
+    for (int i = 0; i < 100; i++) {
+        objects[i] = mem_pool_alloc(pool);
+        cr_assert_not_null(objects[i], "Pool allocation should succeed");
+        cr_assert_eq((uintptr_t)objects[i] % 64, 0, "Pool objects should be aligned");
+        memset(objects[i], i, 40);
+    }
+    
+    mem_pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.object_size, 64, "Objects should be padded to the alignment");
+    cr_assert_eq(stats.objects_in_use, 100, "Pool should count live objects");
+    
+    mem_pool_free(pool, objects[42]);
+    cr_assert_eq(mem_pool_alloc(pool), objects[42], "Freed object should be reused first");
+    mem_pool_destroy(pool);
+    cr_assert(mem_check_integrity(), "Heap should be valid after destroying a pool");
+}
+
+Test(advanced_features, pool_releases_empty_slabs)
+{
+    mem_pool_t *pool = mem_pool_create(32, 0);
+    void *objects[1000];
+    mem_pool_stats_t stats;
+    
+    for (int i = 0; i < 1000; i++) {
+        objects[i] = mem_pool_alloc(pool);
+    }
+    mem_pool_get_stats(pool, &stats);
+    cr_assert_gt(stats.slab_count, 1, "Many objects should need several slabs");
+    
+    for (int i = 0; i < 1000; i++) {
+        mem_pool_free(pool, objects[i]);
+    }
+    mem_pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.objects_in_use, 0, "All objects should be free");
+    cr_assert_eq(stats.slab_count, 1, "Only one empty slab should be kept");
+    mem_pool_destroy(pool);
+}
+
+Test(advanced_features, pool_ignores_foreign_and_double_frees)
+{
+    mem_pool_t *pool = mem_pool_create(48, 0);
+    mem_pool_t *other = mem_pool_create(48, 0);
+    mem_pool_stats_t stats;
+    char local[64];
+    void *object = mem_pool_alloc(pool);
+    void *kept = mem_pool_alloc(pool);
+    void *theirs = mem_pool_alloc(other);
+    void *block = mem_malloc(2000);
+    
+    mem_pool_free(pool, object);
+    mem_pool_free(pool, object);
+    mem_pool_free(pool, theirs);
+    mem_pool_free(pool, block);
+    mem_pool_free(pool, local);
+    
+    mem_pool_get_stats(pool, &stats);
+    cr_assert_eq(stats.objects_in_use, 1, "Only the first free should count");
+    cr_assert_eq(mem_pool_alloc(pool), object, "Freed object should be reused once");
+    cr_assert_neq(mem_pool_alloc(pool), object, "Double free should not queue it twice");
+    mem_pool_get_stats(other, &stats);
+    cr_assert_eq(stats.objects_in_use, 1, "Another pool's object should stay in use");
+    
+    mem_pool_free(pool, kept);
+    mem_free(block);
+    mem_pool_destroy(other);
+    mem_pool_destroy(pool);
+    cr_assert(mem_check_integrity(), "Heap should be valid after rejected frees");
+}
+
+Test(advanced_features, pool_large_alignment)
+{
+    mem_pool_t *pool = mem_pool_create(8, 8192);
+    void *objects[MEM_POOL_MIN_OBJECTS * 2];
+    
+    cr_assert_not_null(pool, "Alignment up to an eighth of the largest slab should be accepted");
+    for (size_t i = 0; i < MEM_POOL_MIN_OBJECTS * 2; i++) {
+        objects[i] = mem_pool_alloc(pool);
+        cr_assert_not_null(objects[i], "Pool should hand out aligned objects");
+        cr_assert_eq((uintptr_t)objects[i] % 8192, 0, "Objects should honour the alignment");
+        memset(objects[i], 0xAB, 8);
+    }
+    cr_assert(mem_check_integrity(), "Aligned objects should stay inside their slabs");
+    for (size_t i = 0; i < MEM_POOL_MIN_OBJECTS * 2; i++) {
+        mem_pool_free(pool, objects[i]);
+    }
+    mem_pool_destroy(pool);
+    
+    cr_assert_null(mem_pool_create(8, 65536), "Alignment no slab can hold should be rejected");
+    cr_assert_null(mem_pool_create(8, (size_t)1 << 30), "Huge alignment should be rejected");
+    cr_assert(mem_check_integrity(), "Heap should be valid after aligned pools");
+}
+
+Test(advanced_features, arena_bump_and_reset)
+{
+    mem_stats_t before, after;
+    mem_get_stats(&before);
+    mem_arena_t *arena = mem_arena_create(4096);
+    mem_arena_stats_t stats;
+    char *first = mem_arena_alloc(arena, 10);
+    char *second = mem_arena_alloc(arena, 10);
+    
+    cr_assert_eq(second - first, 16, "Arena should bump by the aligned size");
+    for (int i = 0; i < 100; i++) {
+        memset(mem_arena_alloc(arena, 100), i, 100);
+    }
+    cr_assert_not_null(mem_arena_alloc(arena, 10000), "Oversized requests get their own chunk");
+    
+    mem_arena_get_stats(arena, &stats);
+    cr_assert_gt(stats.chunk_count, 2, "Arena should have grown");
+    mem_arena_reset(arena);
+    mem_arena_get_stats(arena, &stats);
+    cr_assert_eq(stats.chunk_count, 1, "Reset should keep one chunk");
+    cr_assert_eq(stats.used_bytes, 0, "Reset should release everything");
+    cr_assert_eq(mem_arena_alloc(arena, 10), first, "Reset arena should start over");
+    
+    mem_arena_destroy(arena);
+    mem_get_stats(&after);
+    cr_assert_eq(after.current_usage, before.current_usage, "Destroy should return the chunks");
+}
+
+Test(advanced_features, arena_markers)
+{
+    mem_arena_t *arena = mem_arena_create(1024);
+    mem_arena_alloc(arena, 100);
+    mem_arena_marker_t marker = mem_arena_save(arena);
+    void *expected = mem_arena_alloc(arena, 64);
+    
+    for (int i = 0; i < 50; i++) {
+        mem_arena_alloc(arena, 200);
+    }
+    mem_arena_restore(arena, marker);
+    cr_assert_eq(mem_arena_alloc(arena, 64), expected, "Restore should roll back to the marker");
+    mem_arena_destroy(arena);
+}
+
 Test(advanced_features, fragmentation_test)
 {
     void *ptrs[10];
@@ -134,6 +380,105 @@ Test(advanced_features, fragmentation_test)
     }
 }
 
+Test(advanced_features, freed_block_reused_from_bin)
+{
+    void *ptrs[100];
+    
+    for (int i = 0; i < 100; i++) {
+        ptrs[i] = mem_malloc(100);
+        cr_assert_not_null(ptrs[i], "Allocation %d should succeed", i);
+    }
+    
+    void *hole = ptrs[50];
+    mem_free(hole);
+    
+    void *reused = mem_malloc(100);
+    cr_assert_eq(reused, hole, "Exact-size request should reuse the binned hole");
+    cr_assert(mem_check_integrity(), "Heap should be valid after reuse");
+    
+    mem_free(reused);
+    for (int i = 0; i < 100; i++) {
+        if (i != 50) {
+            mem_free(ptrs[i]);
+        }
+    }
+}
+
+Test(advanced_features, large_blocks_best_fit)
+{
+    void *tight = mem_malloc(2100);
+    void *guard1 = mem_malloc(100);
+    void *loose = mem_malloc(2500);
+    void *guard2 = mem_malloc(100);
+    
+    mem_free(tight);
+    mem_free(loose);
+    cr_assert_eq(mem_malloc(2050), tight, "Smallest fitting free block should be chosen");
+    cr_assert_eq(mem_malloc(2050), loose, "Next best fit should follow");
+    cr_assert(mem_check_integrity(), "Size tree should stay consistent");
+    
+    mem_free(guard1);
+    mem_free(guard2);
+}
+
+Test(advanced_features, tiny_objects_headerless)
+{
+    void *first = mem_malloc(24);
+    void *second = mem_malloc(24);
+    size_t class_size = mem_get_block_size(first);
+    
+    cr_assert(class_size >= 24 && class_size < 24 + MEM_ALIGNMENT, "Tiny class should round up to the alignment");
+    cr_assert_eq((size_t)((char*)first - (char*)second), class_size,
+                 "Neighbouring tiny objects should carry no header");
+    cr_assert_eq((uintptr_t)second % MEM_ALIGNMENT, 0, "Tiny objects should stay aligned");
+    cr_assert_eq(mem_realloc(first, class_size), first, "Realloc within the class should not move");
+    
+    mem_free(first);
+    cr_assert_eq(mem_malloc(24), first, "Freed tiny object should be reused first");
+    cr_assert(mem_check_integrity(), "Tiny runs should match their bitmaps");
+    
+    mem_free(first);
+    mem_free(second);
+}
+
+Test(advanced_features, tiny_double_free_ignored)
+{
+    mem_stats_t stats;
+    void *ptr = mem_malloc(32);
+    
+    mem_free(ptr);
+    mem_free(ptr);
+    mem_flush_thread_cache();
+    mem_free(ptr);
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_frees, 1, "Repeated frees of a tiny object should be ignored");
+    cr_assert_eq(stats.current_usage, 0, "Tiny usage should be released once");
+    cr_assert(mem_check_integrity(), "Tiny runs should survive the double free");
+}
+
+Test(advanced_features, compact_header_coalescing)
+{
+    void *ptr1 = mem_malloc(100);
+    void *ptr2 = mem_malloc(100);
+    void *ptr3 = mem_malloc(100);
+    
+    cr_assert_eq((char*)ptr2 - (char*)ptr1, mem_align_size(100) + sizeof(mem_block_t),
+                 "Heap blocks should only pay an 8-byte header");
+    
+    mem_free(ptr1);
+    mem_free(ptr2);
+    mem_flush_thread_cache();
+    cr_assert(mem_check_integrity(), "Heap should be valid after coalescing");
+    
+    void *merged = mem_malloc(2 * mem_align_size(100) + sizeof(mem_block_t));
+    cr_assert_eq(merged, ptr1, "Coalesced neighbours should satisfy a larger request");
+    
+    mem_free(merged);
+    mem_free(ptr3);
+    cr_assert(mem_check_integrity(), "Heap should be valid after free");
+}
+
 Test(advanced_features, large_allocation)
 {
     size_t large_size = MEM_HEAP_SIZE / 2;
@@ -143,6 +488,342 @@ Test(advanced_features, large_allocation)
     mem_free(ptr);
 }
 
+Test(advanced_features, heap_grows_on_demand)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    size_t size = 4 * MEM_HEAP_SIZE;
+    
+    config.mmap_threshold = 2 * size;
+    mem_cleanup();
+    mem_init_config(&config);
+    
+    char *ptr = mem_malloc(size);
+    cr_assert_not_null(ptr, "Heap should grow past its initial size");
+    cr_assert_not_null(mem_heap_of(ptr), "Block should come from the heap");
+    ptr[size - 1] = 'x';
+    cr_assert(mem_check_integrity(), "Heap should be valid after growing");
+    
+    mem_free(ptr);
+    cr_assert_not_null(mem_malloc(size), "Grown space should be reusable");
+}
+
+Test(advanced_features, growth_stops_at_reserve)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    size_t count = 0;
+    
+    config.heap_size = 64 * 1024;
+    config.heap_reserve = 256 * 1024;
+    mem_cleanup();
+    mem_init_config(&config);
+    
+    while (count <= 16 * MEM_MAX_HEAPS && mem_malloc(16 * 1024) != NULL) {
+        count++;
+    }
+    cr_assert(count >= 12 && count <= 16 * MEM_MAX_HEAPS,
+              "Growth should stop at the reservation (%zu blocks)", count);
+    cr_assert(mem_check_integrity(), "Heap should be valid after exhaustion");
+}
+
+Test(advanced_features, large_allocation_is_mapped)
+{
+    mem_stats_t stats;
+    void *ptr = mem_malloc(MEM_MMAP_THRESHOLD * 4);
+    
+    cr_assert_not_null(ptr, "Large allocation should succeed");
+    cr_assert_null(mem_heap_of(ptr), "Large block should not live in a heap");
+    cr_assert_geq(mem_get_block_size(ptr), MEM_MMAP_THRESHOLD * 4, "Mapping should fit the request");
+    
+    mem_free(ptr);
+    mem_free(ptr);
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "Unmapping should release the usage");
+    cr_assert_eq(stats.num_frees, 1, "Second free of a mapping should be ignored");
+}
+
+Test(advanced_features, realloc_remaps_large_block)
+{
+    size_t size = MEM_MMAP_THRESHOLD * 2;
+    unsigned char *ptr = mem_malloc(size);
+    
+    for (size_t i = 0; i < size; i++) {
+        ptr[i] = (unsigned char)(i * 7);
+    }
+    
+    ptr = mem_realloc(ptr, size * 16);
+    cr_assert_not_null(ptr, "Growing a mapping should succeed");
+    cr_assert_eq(ptr[size - 1], (unsigned char)((size - 1) * 7), "Remap should keep the data");
+    
+    ptr = mem_realloc(ptr, 1000);
+    cr_assert_not_null(mem_heap_of(ptr), "Small realloc should move back to a heap");
+    cr_assert_eq(ptr[999], (unsigned char)(999 * 7), "Move to heap should keep the data");
+    mem_free(ptr);
+}
+
+Test(advanced_features, realloc_extends_in_place)
+{
+    char *ptr = mem_malloc(2048);
+    void *next = mem_malloc(2048);
+    void *guard = mem_malloc(2048);
+    
+    memset(ptr, 'a', 2048);
+    mem_free(next);
+    
+    cr_assert_eq(mem_realloc(ptr, 3600), ptr, "Realloc should absorb the free successor");
+    cr_assert_eq(ptr[2047], 'a', "In-place growth should keep the data");
+    cr_assert(mem_check_integrity(), "Heap should be valid after growing in place");
+    
+    mem_free(ptr);
+    mem_free(guard);
+}
+
+Test(advanced_features, realloc_extends_at_heap_top)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    
+    config.heap_size = 64 * 1024;
+    config.mmap_threshold = 8 * 1024 * 1024;
+    mem_cleanup();
+    mem_init_config(&config);
+    
+    void *ptr = mem_malloc(2048);
+    for (size_t size = 4096; size <= 4 * 1024 * 1024; size *= 2) {
+        cr_assert_eq(mem_realloc(ptr, size), ptr, "Top block should grow without moving");
+    }
+    cr_assert(mem_check_integrity(), "Heap should be valid after growing the top");
+    mem_free(ptr);
+}
+
+Test(advanced_features, realloc_shrink_merges_tail)
+{
+    char *ptr = mem_malloc(4096);
+    void *next = mem_malloc(2048);
+    char *guard = mem_malloc(2048);
+    
+    mem_free(next);
+    cr_assert_eq(mem_realloc(ptr, 1024), ptr, "Shrinking should stay in place");
+    
+    char *reused = mem_malloc(4800);
+    cr_assert(reused > ptr && reused < guard, "Tail and free successor should form one block");
+    
+    mem_free(reused);
+    mem_free(ptr);
+    mem_free(guard);
+}
+
+Test(advanced_features, sized_free_releases_every_kind)
+{
+    mem_stats_t stats;
+    void *tiny = mem_malloc(40);
+    void *small = mem_malloc(200);
+    void *large = mem_malloc(MEM_MMAP_THRESHOLD * 2);
+    
+    mem_free_sized(tiny, 40);
+    mem_free_sized(small, 200);
+    mem_free_sized(large, MEM_MMAP_THRESHOLD * 2);
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_frees, 3, "Every sized free should count");
+    cr_assert_eq(stats.current_usage, 0, "Sized frees should release the block sizes");
+    cr_assert_eq(mem_malloc(40), tiny, "Tiny object should be back in its class");
+    cr_assert_eq(mem_malloc(200), small, "Heap block should be back in the thread cache");
+    cr_assert(mem_check_integrity(), "Heap should be valid after sized frees");
+}
+
+Test(advanced_features, realloc_sized_moves_across_tiny_classes)
+{
+    char *ptr = mem_malloc(60);
+    
+    memset(ptr, 0x5A, 60);
+    cr_assert_eq(mem_realloc_sized(ptr, 60, 58), ptr, "Same class should not move");
+    
+    char *moved = mem_realloc_sized(ptr, 58, 10);
+    cr_assert_neq(moved, ptr, "Smaller class should move");
+    cr_assert_eq(moved[9], 0x5A, "Contents should be preserved");
+    cr_assert_eq(mem_get_block_size(moved), mem_tiny_class_size(9 / MEM_ALIGNMENT), "New class should fit the size");
+    
+    moved = mem_realloc(moved, 40);
+    cr_assert_eq(mem_get_block_size(moved), mem_tiny_class_size(39 / MEM_ALIGNMENT), "Plain realloc should also leave the class");
+    mem_free_sized(moved, 40);
+    cr_assert(mem_check_integrity(), "Tiny runs should match their bitmaps");
+}
+
+Test(advanced_features, sized_free_after_shrinking_a_mapping)
+{
+    mem_stats_t stats;
+    void *wide = mem_malloc(40);
+    
+    for (int i = 0; i < 64; i++) {
+        char *ptr = mem_malloc(MEM_MMAP_THRESHOLD * 2);
+        ptr[6] = (char)i;
+        ptr = mem_realloc(ptr, 7);
+        cr_assert_eq(ptr[6], (char)i, "Contents should survive the move to a tiny class");
+        if (i % 2 == 0) {
+            mem_free_sized(ptr, 7);
+        } else {
+            ptr = mem_realloc_sized(ptr, 7, 50);
+            cr_assert_eq(ptr[6], (char)i, "Contents should survive the sized realloc");
+            mem_free_sized(ptr, 50);
+        }
+    }
+    
+    /* A size below the object's class must not reach the class it names */
+    mem_free_sized(wide, 7);
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "Every object should be released");
+    cr_assert(mem_check_integrity(), "Tiny runs should match their bitmaps");
+    cr_assert_eq(mem_malloc(40), wide, "Mismatched object should be back in its own class");
+}
+
+Test(advanced_features, batch_carves_neighbouring_blocks)
+{
+    void *ptrs[64];
+    mem_stats_t stats;
+    size_t size = 200;
+    
+    cr_assert_eq(mem_malloc_batch(size, 64, ptrs), 64, "Batch should be filled");
+    for (size_t i = 1; i < 64; i++) {
+        cr_assert_eq((char*)ptrs[i] - (char*)ptrs[i - 1], (ptrdiff_t)(mem_align_size(size) + MEM_HEADER_SIZE),
+                     "Batch blocks should be carved end to end");
+    }
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_allocations, 64, "Every batch block should count");
+    cr_assert_eq(stats.current_usage, 64 * mem_align_size(size), "Usage should cover the batch");
+    cr_assert(mem_check_integrity(), "Heap should be valid after a batch");
+}
+
+Test(advanced_features, free_batch_coalesces_in_any_order)
+{
+    void *ptrs[48];
+    void *tiny[16];
+    mem_stats_t stats;
+    
+    cr_assert_eq(mem_malloc_batch(1000, 48, ptrs), 48, "Heap batch should be filled");
+    cr_assert_eq(mem_malloc_batch(24, 16, tiny), 16, "Tiny batch should be filled");
+    void *first = ptrs[0];
+    void *kept = ptrs[10];
+    ptrs[10] = ptrs[20];
+    for (size_t i = 0; i < 24; i++) {
+        void *swap = ptrs[i];
+        ptrs[i] = ptrs[47 - i];
+        ptrs[47 - i] = swap;
+    }
+    
+    mem_free_batch(tiny, 16);
+    mem_free_batch(ptrs, 48);
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_frees, 63, "Duplicates in a batch should be freed once");
+    cr_assert_eq(stats.current_usage, mem_get_block_size(kept), "Only the block left out should stay in use");
+    cr_assert(mem_check_integrity(), "Heap should be valid after a batch free");
+    cr_assert_eq(mem_malloc(10 * 1000), first, "Blocks in front of the kept one should form one free block");
+    
+    mem_free(first);
+    mem_free(kept);
+}
+
+Test(advanced_features, batch_rejects_huge_sizes)
+{
+    void *ptrs[4];
+    mem_stats_t stats;
+    
+    cr_assert_eq(mem_malloc_batch(SIZE_MAX, 4, ptrs), 0, "A batch of SIZE_MAX blocks should fail");
+    cr_assert_eq(mem_malloc_batch(SIZE_MAX - 7, 4, ptrs), 0, "A batch of wrapping sizes should fail");
+    cr_assert_eq(mem_malloc_batch((size_t)PTRDIFF_MAX + 1, 4, ptrs), 0, "A batch past PTRDIFF_MAX should fail");
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_allocations, 0, "Failed batches should allocate nothing");
+}
+
+static void churn_free_pages(void **ptrs, size_t count, size_t size)
+{
+    for (size_t i = 0; i < count; i++) {
+        ptrs[i] = mem_malloc(size);
+        memset(ptrs[i], 0xAB, size);
+    }
+    for (size_t i = 0; i < count; i++) {
+        mem_free(ptrs[i]);
+    }
+}
+
+Test(advanced_features, free_pages_wait_for_decay)
+{
+    void *ptrs[4];
+    mem_stats_t stats;
+    
+    churn_free_pages(ptrs, 4, 64 * 1024);
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.purged_bytes, 0, "Nothing should be purged before the decay");
+    cr_assert_geq(stats.retained_bytes, 4 * 64 * 1024, "Freed pages should be retained");
+    
+    mem_purge();
+    mem_get_stats(&stats);
+    cr_assert_geq(stats.purged_bytes, 3 * 64 * 1024, "mem_purge should release free pages");
+    cr_assert_lt(stats.retained_bytes, 64 * 1024, "Little free memory should stay resident");
+    cr_assert(mem_check_integrity(), "Heap should be valid after purging");
+}
+
+Test(advanced_features, zero_decay_purges_on_free)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    void *ptrs[4];
+    mem_stats_t stats;
+    
+    config.decay_ms = 0;
+    mem_cleanup();
+    mem_init_config(&config);
+    
+    churn_free_pages(ptrs, 4, 64 * 1024);
+    mem_get_stats(&stats);
+    cr_assert_geq(stats.purged_bytes, 3 * 64 * 1024, "Zero decay should purge on free");
+    
+    char *reused = mem_malloc(200 * 1024 - 64);
+    cr_assert_not_null(reused, "Purged memory should be reusable");
+    memset(reused, 1, 200 * 1024 - 64);
+    cr_assert(mem_check_integrity(), "Heap should be valid after reuse");
+}
+
+static bool is_all_zero(const unsigned char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Test(advanced_features, calloc_zeroes_purged_and_dirty_blocks)
+{
+    void *ptrs[4];
+    size_t size = 3 * 64 * 1024;
+    
+    churn_free_pages(ptrs, 4, 64 * 1024);
+    unsigned char *dirty = mem_calloc(1, size);
+    cr_assert(is_all_zero(dirty, size), "calloc should clear reused dirty memory");
+    memset(dirty, 0xCD, size);
+    mem_free(dirty);
+    
+    mem_purge();
+    unsigned char *clean = mem_calloc(size / 8, 8);
+    cr_assert_eq(clean, dirty, "calloc should reuse the purged block");
+    cr_assert(is_all_zero(clean, size), "calloc should clear the bookkeeping of clean memory");
+    cr_assert(mem_check_integrity(), "Heap should be valid after calloc");
+    mem_free(clean);
+}
+
+Test(advanced_features, large_calloc_is_mapped)
+{
+    size_t size = 4 * MEM_MMAP_THRESHOLD;
+    unsigned char *table = mem_calloc(size / 16, 16);
+    
+    cr_assert_not_null(table, "Large calloc should succeed");
+    cr_assert_null(mem_heap_of(table), "Large calloc should get its own mapping");
+    cr_assert(is_all_zero(table, size), "Fresh mapping should read as zero");
+    mem_free(table);
+}
+
 Test(advanced_features, stress_test)
 {
     const int iterations = 1000;
@@ -174,6 +855,27 @@ Test(error_handling, invalid_pointer_free)
     cr_assert(mem_check_integrity(), "free() with invalid pointer should not corrupt heap");
 }
 
+Test(error_handling, foreign_pointers_never_read)
+{
+    mem_stats_t stats;
+    char *unmapped = mmap(NULL, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void *heap_ptr = mem_malloc(100);
+    int local = 0;
+    
+    cr_assert_neq(unmapped, MAP_FAILED, "Test mapping should succeed");
+    mem_free(unmapped + 32);
+    mem_free(&local);
+    mem_free((char*)mem_heaps[0].end + 64);
+    cr_assert_eq(mem_get_block_size(unmapped + 32), 0, "Unmapped pointer should have no size");
+    cr_assert_null(mem_realloc(unmapped + 64, 200), "Foreign pointer should not be reallocated");
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_frees, 0, "Foreign pointers should not count as frees");
+    cr_assert(mem_check_integrity(), "Heap should be unaffected");
+    mem_free(heap_ptr);
+    munmap(unmapped, 4096);
+}
+
 Test(error_handling, double_free)
 {
     void *ptr = mem_malloc(100);
@@ -202,6 +904,51 @@ Test(error_handling, realloc_zero_size)
     cr_assert_null(ptr, "realloc(ptr, 0) should work like free and return NULL");
 }
 
+Test(error_handling, huge_mappings_fail)
+{
+    char *ptr = mem_malloc(MEM_MMAP_THRESHOLD * 2);
+    cr_assert_not_null(ptr, "Mapped allocation should succeed");
+    memset(ptr, 0x5A, MEM_MMAP_THRESHOLD * 2);
+    
+    cr_assert_null(mem_malloc(SIZE_MAX - 7), "A mapping past the address space should fail");
+    cr_assert_null(mem_realloc(ptr, SIZE_MAX - 7), "Remapping past the address space should fail");
+    cr_assert_geq(mem_get_block_size(ptr), MEM_MMAP_THRESHOLD * 2, "Failed remap should keep the mapping");
+    cr_assert_eq(ptr[MEM_MMAP_THRESHOLD * 2 - 1], 0x5A, "Failed remap should keep the contents");
+    
+    mem_free(ptr);
+    cr_assert(mem_check_integrity(), "Heap should be valid after failed mappings");
+}
+
+Test(error_handling, realloc_huge_size_keeps_block)
+{
+    static const size_t sizes[] = { SIZE_MAX, SIZE_MAX - 7, (size_t)PTRDIFF_MAX + 1 };
+    void *tiny = mem_malloc(20);
+    char *ptr = mem_malloc(1000);
+    
+    memset(ptr, 0x3C, 1000);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        cr_assert_null(mem_realloc(ptr, sizes[i]), "realloc past PTRDIFF_MAX should fail");
+        cr_assert_null(mem_realloc(tiny, sizes[i]), "realloc of a tiny block past PTRDIFF_MAX should fail");
+    }
+    cr_assert_geq(mem_get_block_size(ptr), 1000, "Failed realloc should keep the block size");
+    for (size_t i = 0; i < 1000; i++) {
+        cr_assert_eq(ptr[i], 0x3C, "Failed realloc should keep the contents");
+    }
+    
+    mem_free(tiny);
+    mem_free(ptr);
+    cr_assert(mem_check_integrity(), "Heap should be valid after failed reallocs");
+}
+
+Test(error_handling, calloc_huge_totals_fail)
+{
+    cr_assert_null(mem_calloc(SIZE_MAX, 2), "calloc whose product overflows should fail");
+    cr_assert_null(mem_calloc(SIZE_MAX, 1), "calloc of SIZE_MAX bytes should fail");
+    cr_assert_null(mem_calloc(1, SIZE_MAX - 7), "calloc whose aligned total wraps should fail");
+    cr_assert_null(mem_calloc(2, (size_t)PTRDIFF_MAX / 2 + 1), "calloc past PTRDIFF_MAX should fail");
+    cr_assert(mem_check_integrity(), "Heap should be valid after failed callocs");
+}
+
 Test(statistics, stats_tracking)
 {
     mem_stats_t stats_before, stats_after;
@@ -234,6 +981,78 @@ Test(statistics, leak_detection)
     mem_free(ptr2);
 }
 
+Test(statistics, leak_table_follows_debug_calls)
+{
+    void *ptrs[2000];
+    mem_leak_t leaks[2];
+    
+    for (int i = 0; i < 2000; i++) {
+        ptrs[i] = MALLOC((size_t)(i % 50) * 8 + 8);
+    }
+    for (int i = 1; i < 2000; i += 2) {
+        FREE(ptrs[i]);
+    }
+    
+    cr_assert_eq(mem_get_leaks(leaks, 2), 1000, "Freed blocks should leave the table");
+    cr_assert_eq(leaks[0].line, leaks[1].line, "Blocks should carry their call site");
+    cr_assert_str_eq(leaks[0].file, __FILE__, "Blocks should carry their file");
+    for (int i = 0; i < 2000; i++) {
+        cr_assert_eq(mem_leak_is_tracked(ptrs[i]), i % 2 == 0,
+                     "Block %d should be found after removals shifted the table", i);
+    }
+    
+    mem_detect_leaks();
+    for (int i = 0; i < 2000; i += 2) {
+        FREE(ptrs[i]);
+    }
+    cr_assert_eq(mem_get_leaks(NULL, 0), 0, "Every block should be released");
+}
+
+static void read_profile(FILE *file, char *buffer, size_t size)
+{
+    size_t length;
+    
+    fflush(file);
+    rewind(file);
+    length = fread(buffer, 1, size - 1, file);
+    buffer[length] = '\0';
+}
+
+Test(statistics, heap_profile_samples_allocations)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    FILE *file = tmpfile();
+    static char profile[1 << 16];
+    void *ptrs[10];
+    
+    config.sample_interval = 1;
+    mem_cleanup();
+    mem_init_config(&config);
+    
+    mem_free(mem_malloc(100));      /* the first crossing only arms the countdown */
+    for (int i = 0; i < 10; i++) {
+        ptrs[i] = mem_malloc(100);
+        cr_assert_null(mem_heap_of(ptrs[i]), "A sampled block should get its own mapping");
+    }
+    for (int i = 0; i < 4; i++) {
+        mem_free(ptrs[i]);
+    }
+    
+    cr_assert_eq(mem_heap_profile_dump(fileno(file)), 0, "Dumping should succeed");
+    read_profile(file, profile, sizeof(profile));
+    cr_assert_not_null(strstr(profile, "heap profile: 6: 600 [10: 1000] @ heap_v2/1\n"),
+                       "Header should total live and cumulative samples");
+    cr_assert_not_null(strstr(profile, "\nMAPPED_LIBRARIES:\n"), "Mappings should follow the samples");
+    
+    ptrs[0] = mem_realloc(ptrs[4], 5000);
+    cr_assert_not_null(ptrs[0], "A sampled block should grow like any other");
+    mem_free(ptrs[0]);
+    for (int i = 5; i < 10; i++) {
+        mem_free(ptrs[i]);
+    }
+    fclose(file);
+}
+
 Test(statistics, integrity_check)
 {
     void *ptr = mem_malloc(100);
@@ -244,3 +1063,399 @@ Test(statistics, integrity_check)
     mem_free(ptr);
     cr_assert(mem_check_integrity(), "Heap integrity should remain valid after free");
 }
+
+Test(statistics, free_totals_follow_holes)
+{
+    void *ptrs[8];
+    mem_stats_t before, holes, after;
+    
+    mem_get_stats(&before);
+    for (int i = 0; i < 8; i++) {
+        ptrs[i] = mem_malloc(4096);
+        cr_assert_not_null(ptrs[i], "Allocation %d should succeed", i);
+    }
+    for (int i = 0; i < 8; i += 2) {
+        mem_free(ptrs[i]);
+    }
+    
+    mem_get_stats(&holes);
+    cr_assert_eq(holes.free_blocks, before.free_blocks + 4, "Each hole should be a free block");
+    cr_assert_eq(holes.free_bytes + 4 * mem_align_size(4096) + 8 * MEM_HEADER_SIZE, before.free_bytes,
+                 "Free bytes should drop by the blocks in use and every header");
+    cr_assert_gt(holes.fragmentation_ratio, before.fragmentation_ratio,
+                 "Holes should count as fragmentation");
+    cr_assert_eq(holes.fragmentation_ratio,
+                 (holes.free_bytes - holes.largest_free) * 100 / holes.free_bytes,
+                 "Fragmentation should be 1 - largest / free");
+    cr_assert(mem_check_integrity(), "Counters should match the block list");
+    
+    for (int i = 1; i < 8; i += 2) {
+        mem_free(ptrs[i]);
+    }
+    mem_get_stats(&after);
+    cr_assert_eq(after.free_blocks, before.free_blocks, "Frees should merge back into one block");
+    cr_assert_eq(after.free_bytes, before.free_bytes, "All bytes should be free again");
+    cr_assert_eq(after.largest_free, before.largest_free, "The top block should be whole again");
+}
+
+Test(statistics, size_histogram_counts_requests)
+{
+    mem_size_histogram_t before, after;
+    mem_stats_t stats;
+    void *tiny[3];
+    size_t free_blocks = 0;
+    
+    mem_get_size_histogram(&before);
+    for (int i = 0; i < 3; i++) {
+        tiny[i] = mem_malloc(24);
+    }
+    void *page = mem_malloc(4096);
+    mem_get_size_histogram(&after);
+    
+    cr_assert_eq(after.requests[mem_stats_class(mem_get_block_size(tiny[0]))],
+                 before.requests[mem_stats_class(mem_get_block_size(tiny[0]))] + 3,
+                 "Tiny requests should land in their class");
+    cr_assert_eq(after.requests[mem_stats_class(4096)], before.requests[mem_stats_class(4096)] + 1,
+                 "A page request should land in the 4 KB class");
+    
+    mem_get_stats(&stats);
+    for (size_t i = 0; i < MEM_STATS_CLASSES; i++) {
+        free_blocks += after.free_blocks[i];
+    }
+    cr_assert_eq(free_blocks, stats.free_blocks, "The histogram should cover every free block");
+    
+    for (int i = 0; i < 3; i++) {
+        mem_free(tiny[i]);
+    }
+    mem_free(page);
+}
+
+Test(statistics, disabled_stats_count_nothing)
+{
+    mem_config_t config = MEM_CONFIG_DEFAULT;
+    mem_stats_t stats;
+    
+    config.disable_stats = true;
+    mem_cleanup();
+    mem_init_config(&config);
+    
+    void *ptr = mem_malloc(100);
+    mem_free(mem_malloc(5000));
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_allocations, 0, "Disabled statistics should not count allocations");
+    cr_assert_eq(stats.total_freed, 0, "Disabled statistics should not count frees");
+    cr_assert_gt(stats.num_blocks, 0, "Heap state should still be reported");
+    mem_free(ptr);
+}
+
+static void* stress_worker(void *arg)
+{
+    unsigned seed = (unsigned)(size_t)arg;
+    unsigned char *slots[STRESS_SLOTS] = {0};
+    size_t sizes[STRESS_SLOTS] = {0};
+    
+    for (int i = 0; i < STRESS_OPERATIONS; i++) {
+        int slot = rand_r(&seed) % STRESS_SLOTS;
+        
+        if (slots[slot] != NULL) {
+            if (slots[slot][0] != (unsigned char)slot || slots[slot][sizes[slot] - 1] != (unsigned char)slot) {
+                return (void*)1;
+            }
+            mem_free(slots[slot]);
+            slots[slot] = NULL;
+            continue;
+        }
+        
+        sizes[slot] = (size_t)(rand_r(&seed) % 512) + 1;
+        slots[slot] = mem_malloc(sizes[slot]);
+        if (slots[slot] != NULL) {
+            memset(slots[slot], slot, sizes[slot]);
+        }
+    }
+    
+    for (int i = 0; i < STRESS_SLOTS; i++) {
+        mem_free(slots[i]);
+    }
+    return NULL;
+}
+
+static void* free_worker(void *arg)
+{
+    void **ptrs = arg;
+    
+    for (int i = 0; i < 1000; i++) {
+        mem_free(ptrs[i]);
+    }
+    return NULL;
+}
+
+Test(concurrency, parallel_stress)
+{
+    pthread_t threads[STRESS_THREADS];
+    
+    for (size_t i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&threads[i], NULL, stress_worker, (void*)(i + 1));
+    }
+    for (size_t i = 0; i < STRESS_THREADS; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        cr_assert_null(result, "Thread %zu saw corrupted payload", i);
+    }
+    
+    cr_assert(mem_check_integrity(), "Heap should be valid after contention");
+    
+    mem_stats_t stats;
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "All memory should be released");
+}
+
+Test(concurrency, cross_thread_free)
+{
+    void *ptrs[1000];
+    pthread_t thread;
+    
+    for (int i = 0; i < 1000; i++) {
+        ptrs[i] = mem_malloc((size_t)(i % 200) + 1);
+        cr_assert_not_null(ptrs[i], "Allocation %d should succeed", i);
+    }
+    
+    pthread_create(&thread, NULL, free_worker, ptrs);
+    pthread_join(thread, NULL);
+    
+    cr_assert(mem_check_integrity(), "Heap should be valid after remote frees");
+    
+    mem_stats_t stats;
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "Remote frees should release memory");
+}
+
+static void* single_free_worker(void *arg)
+{
+    mem_free(arg);
+    return NULL;
+}
+
+Test(concurrency, remote_free_drained_by_owner)
+{
+    void *ptr = mem_malloc(2000);
+    mem_heap_t *owner = mem_heap_of(ptr);
+    pthread_t thread;
+    
+    pthread_create(&thread, NULL, single_free_worker, ptr);
+    pthread_join(thread, NULL);
+    
+    cr_assert_not_null(owner->remote_frees, "Foreign free should be queued on the owner");
+    cr_assert_eq(mem_malloc(2000), ptr, "Owner should drain and reuse the block");
+    cr_assert_null(owner->remote_frees, "Remote stack should be empty after draining");
+}
+
+static void* keep_worker(void *arg)
+{
+    void **ptrs = arg;
+    
+    for (int i = 0; i < 100; i++) {
+        ptrs[i] = mem_malloc((size_t)(i % 4) * 1000 + 40);
+    }
+    return NULL;
+}
+
+Test(concurrency, stats_survive_thread_exit)
+{
+    void *ptrs[100];
+    pthread_t thread;
+    size_t bytes = 0;
+    mem_stats_t stats;
+    
+    pthread_create(&thread, NULL, keep_worker, ptrs);
+    pthread_join(thread, NULL);
+    for (int i = 0; i < 100; i++) {
+        bytes += mem_get_block_size(ptrs[i]);
+    }
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_allocations, 100, "An exited thread's allocations should still count");
+    cr_assert_eq(stats.current_usage, bytes, "An exited thread's usage should still count");
+    cr_assert_geq(stats.peak_usage, bytes, "Peak should cover the current usage");
+    
+    for (int i = 0; i < 100; i++) {
+        mem_free(ptrs[i]);
+    }
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "Frees on another thread should cancel the usage");
+}
+
+static void* arena_churn_worker(void *arg)
+{
+    mem_arena_t *arena = arg;
+    
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 64; i++) {
+            mem_arena_alloc(arena, 500);
+        }
+        mem_arena_reset(arena);
+    }
+    return NULL;
+}
+
+Test(concurrency, arena_stats_from_another_thread)
+{
+    mem_arena_t *arena = mem_arena_create(4096);
+    mem_arena_stats_t stats;
+    pthread_t thread;
+    
+    pthread_create(&thread, NULL, arena_churn_worker, arena);
+    for (int i = 0; i < 2000; i++) {
+        mem_arena_get_stats(arena, &stats);
+        cr_assert_leq(stats.used_bytes, stats.chunk_bytes, "Snapshot should see a consistent chunk stack");
+    }
+    pthread_join(thread, NULL);
+    
+    mem_arena_get_stats(arena, &stats);
+    cr_assert_eq(stats.chunk_count, 1, "Reset should keep one chunk");
+    mem_arena_destroy(arena);
+}
+
+static void* cache_churn_worker(void *arg)
+{
+    void *ptrs[100];
+    
+    (void)arg;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 100; i++) {
+            ptrs[i] = mem_malloc((size_t)(i % 8) * 16 + 72);
+        }
+        for (int i = 0; i < 100; i++) {
+            mem_free(ptrs[i]);
+        }
+    }
+    return NULL;
+}
+
+static size_t count_cached_blocks(void)
+{
+    size_t cached = 0;
+    
+    for (size_t i = 0; i < MEM_MAX_HEAPS; i++) {
+        mem_block_t *block = mem_heaps[i].ready ? mem_heaps[i].first_block : NULL;
+        for (; block != NULL; block = mem_next_block(block)) {
+            cached += (!mem_block_is_free(block) && mem_tcache_is_cached(block)) ? 1 : 0;
+        }
+    }
+    return cached;
+}
+
+Test(concurrency, thread_cache_drained_on_exit)
+{
+    pthread_t thread;
+    
+    pthread_create(&thread, NULL, cache_churn_worker, NULL);
+    pthread_join(thread, NULL);
+    
+    cr_assert_eq(count_cached_blocks(), 0, "Exited thread should leave no cached blocks");
+    cr_assert(mem_check_integrity(), "Heap should be valid after the cache drained");
+}
+
+Test(concurrency, thread_cache_reuses_block)
+{
+    void *ptr = mem_malloc(100);
+    mem_free(ptr);
+    
+    cr_assert_eq(mem_malloc(100), ptr, "Cached block should be handed out again");
+    cr_assert_eq(count_cached_blocks(), MEM_TCACHE_BATCH - 1, "Refill batch should stay cached");
+}
+
+/* Frees the block only when this thread shares the block's heap */
+static void* same_heap_free_worker(void *arg)
+{
+    if (mem_thread_heap() != mem_heap_of(arg)) {
+        return NULL;
+    }
+    mem_free(arg);
+    return arg;
+}
+
+Test(concurrency, double_free_on_same_heap_ignored)
+{
+    void *ptr = mem_malloc(100);
+    void *freed = NULL;
+    
+    mem_free(ptr);
+    for (int i = 0; i < 64 && freed == NULL; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, same_heap_free_worker, ptr);
+        pthread_join(thread, &freed);
+    }
+    cr_assert_eq(freed, ptr, "A thread should share the main thread's heap");
+    
+    cr_assert(!mem_block_is_free(mem_ptr_to_block(ptr)), "Second free should not release the cached block");
+    cr_assert_eq(mem_malloc(100), ptr, "Cached block should be handed out again");
+    cr_assert_neq(mem_malloc(100), ptr, "Cached block should be handed out only once");
+    cr_assert(mem_check_integrity(), "Heap should be valid after a double free on the same heap");
+}
+
+static bool churn_stop = false;
+
+static void* fork_churn_worker(void *arg)
+{
+    (void)arg;
+    while (!__atomic_load_n(&churn_stop, __ATOMIC_ACQUIRE)) {
+        void *small = mem_malloc(40);
+        void *large = mem_malloc(200 * 1024);
+        mem_free(large);
+        mem_free(small);
+    }
+    return NULL;
+}
+
+Test(concurrency, fork_while_allocating)
+{
+    pthread_t thread;
+    
+    pthread_atfork(mem_fork_prepare, mem_fork_parent, mem_fork_child);
+    pthread_create(&thread, NULL, fork_churn_worker, NULL);
+    for (int i = 0; i < 20; i++) {
+        int status = 0;
+        pid_t pid = fork();
+        if (pid == 0) {
+            void *ptr = mem_malloc(300);
+            mem_free(ptr);
+            _exit(ptr != NULL && mem_check_integrity() ? 0 : 1);
+        }
+        waitpid(pid, &status, 0);
+        cr_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child %d should allocate after fork", i);
+    }
+    __atomic_store_n(&churn_stop, true, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+}
+
+Test(per_cpu_cache, parallel_stress)
+{
+    pthread_t threads[STRESS_THREADS];
+    mem_stats_t stats;
+    
+    for (size_t i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&threads[i], NULL, stress_worker, (void*)(i + 1));
+    }
+    for (size_t i = 0; i < STRESS_THREADS; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        cr_assert_null(result, "Thread %zu saw corrupted payload", i);
+    }
+    
+    cr_assert(mem_check_integrity(), "Heap should be valid with per-CPU caches");
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.current_usage, 0, "All memory should be released");
+}
+
+Test(per_cpu_cache, double_free_rejected)
+{
+    mem_stats_t stats;
+    void *ptr = mem_malloc(100);
+    
+    mem_free(ptr);
+    mem_free(ptr);
+    
+    mem_get_stats(&stats);
+    cr_assert_eq(stats.num_frees, 1, "Second free of a cached block should be ignored");
+    cr_assert(mem_check_integrity(), "Heap should survive the double free");
+}
@@ -0,0 +1,237 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - C++ Unit Tests
+ * ============================================================================
+ * 
+ * This file contains the unit tests for the C++ layer: the replaced
+ * global operator new and delete of mem_new.cpp and the allocator and
+ * memory resources of mem_alloc.hpp. It is linked with the C++ library
+ * objects, so every new and delete in it goes through the allocator,
+ * and the tests check that through the statistics.
+ * 
+ * Test Categories:
+ * - Global new and delete, plain, array, nothrow, sized and aligned
+ * - Standard containers on memalloc::allocator
+ * - Polymorphic containers on the heap and arena resources
+ * 
+ * ============================================================================
+ */
+
+#include <criterion/criterion.h>
+#include "../include/mem_alloc.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+#define CPP_ELEMENTS        10000
+
+static void setup(void)
+{
+    mem_cleanup();
+    mem_init(MEM_HEAP_SIZE);
+}
+
+static void teardown(void)
+{
+    mem_cleanup();
+}
+
+static mem_stats_t current_stats(void)
+{
+    mem_stats_t stats;
+    
+    mem_get_stats(&stats);
+    return stats;
+}
+
+static bool is_aligned(const void *ptr, std::size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+/* Resources never return nullptr, so returning at all means no throw */
+static bool allocation_throws(std::pmr::memory_resource *resource, std::size_t bytes, std::size_t alignment)
+{
+    try {
+        return resource->allocate(bytes, alignment) == nullptr;
+    } catch (const std::bad_alloc&) {
+        return true;
+    }
+}
+
+struct alignas(64) cache_line {
+    char bytes[64];
+};
+
+TestSuite(global_new, .init = setup, .fini = teardown);
+TestSuite(std_allocator, .init = setup, .fini = teardown);
+TestSuite(memory_resources, .init = setup, .fini = teardown);
+
+Test(global_new, new_delete_round_trip)
+{
+    mem_stats_t before = current_stats();
+    
+    int *value = new int(42);
+    cr_assert_not_null(value, "new should return valid pointer");
+    cr_assert_eq(*value, 42, "new should construct the object");
+    cr_assert_geq(mem_get_block_size(value), sizeof(int), "new should allocate from the heaps");
+    delete value;
+    
+    int *values = new int[100]();
+    cr_assert_geq(mem_get_block_size(values), 100 * sizeof(int), "new[] should allocate from the heaps");
+    delete[] values;
+    
+    void *nothrow = ::operator new(200, std::nothrow);
+    cr_assert_not_null(nothrow, "nothrow new should return valid pointer");
+    ::operator delete(nothrow, std::nothrow);
+    
+    mem_stats_t after = current_stats();
+    cr_assert_eq(after.num_allocations - before.num_allocations, 3, "Every new should be counted");
+    cr_assert_eq(after.num_frees - before.num_frees, 3, "Every delete should be counted");
+    cr_assert_eq(after.current_usage, before.current_usage, "Deleting should return all usage");
+    cr_assert(mem_check_integrity(), "Heap should be valid after delete");
+}
+
+Test(global_new, sized_and_aligned_delete)
+{
+    static const std::size_t sizes[] = { 1, 7, 48, 100, 1000, 100000, 1 << 20 };
+    mem_stats_t before = current_stats();
+    
+    for (std::size_t size : sizes) {
+        void *plain = ::operator new(size);
+        ::operator delete(plain, size);
+        
+        void *array = ::operator new[](size);
+        ::operator delete[](array, size);
+        
+        void *aligned = ::operator new(size, std::align_val_t(256));
+        cr_assert(is_aligned(aligned, 256), "Aligned new should honour the alignment");
+        ::operator delete(aligned, size, std::align_val_t(256));
+        
+        void *aligned_array = ::operator new[](size, std::align_val_t(128), std::nothrow);
+        cr_assert(is_aligned(aligned_array, 128), "Aligned nothrow new[] should honour the alignment");
+        ::operator delete[](aligned_array, std::align_val_t(128));
+    }
+    
+    mem_stats_t after = current_stats();
+    cr_assert_eq(after.current_usage, before.current_usage, "Sized and aligned delete should return all usage");
+    cr_assert(mem_check_integrity(), "Heap should be valid after sized and aligned delete");
+}
+
+Test(global_new, over_aligned_types)
+{
+    cache_line *line = new cache_line();
+    cr_assert(is_aligned(line, alignof(cache_line)), "new of an over-aligned type should align it");
+    delete line;
+    
+    cache_line *lines = new cache_line[9];
+    cr_assert(is_aligned(lines, alignof(cache_line)), "new[] of an over-aligned type should align it");
+    for (int i = 0; i < 9; i++) {
+        lines[i].bytes[63] = static_cast<char>(i);
+    }
+    delete[] lines;
+    
+    std::vector<cache_line> vector(33);
+    cr_assert(is_aligned(vector.data(), alignof(cache_line)), "std::vector should get aligned storage");
+    cr_assert(mem_check_integrity(), "Heap should be valid after over-aligned new");
+}
+
+Test(std_allocator, vector_growth)
+{
+    mem_stats_t before = current_stats();
+    
+    {
+        std::vector<std::size_t, memalloc::allocator<std::size_t>> vector;
+        for (std::size_t i = 0; i < CPP_ELEMENTS; i++) {
+            vector.push_back(i * 3);
+        }
+        for (std::size_t i = 0; i < CPP_ELEMENTS; i++) {
+            cr_assert_eq(vector[i], i * 3, "Elements should survive growth");
+        }
+        cr_assert_geq(mem_get_block_size(vector.data()), CPP_ELEMENTS * sizeof(std::size_t),
+                      "Storage should come from the heaps");
+        
+        vector.resize(10);
+        vector.shrink_to_fit();
+        cr_assert_eq(vector[9], 27, "Elements should survive shrinking");
+    }
+    
+    mem_stats_t after = current_stats();
+    cr_assert_gt(after.num_allocations, before.num_allocations, "Growth should allocate");
+    cr_assert_eq(after.current_usage, before.current_usage, "Destruction should return all usage");
+    cr_assert(mem_check_integrity(), "Heap should be valid after vector growth");
+}
+
+Test(std_allocator, rebinds_and_over_aligned_types)
+{
+    using string = std::basic_string<char, std::char_traits<char>, memalloc::allocator<char>>;
+    std::vector<string, memalloc::allocator<string>> strings;
+    std::vector<cache_line, memalloc::allocator<cache_line>> lines(17);
+    
+    for (int i = 0; i < 100; i++) {
+        strings.push_back(string(static_cast<std::size_t>(i) * 10, 'a'));
+    }
+    cr_assert_eq(strings[99].size(), 990, "Rebound strings should keep their contents");
+    cr_assert(is_aligned(lines.data(), alignof(cache_line)), "Over-aligned elements should be aligned");
+    cr_assert(memalloc::allocator<int>() == memalloc::allocator<char>(), "Allocators should compare equal");
+}
+
+Test(memory_resources, heap_resource_vector_growth)
+{
+    mem_stats_t before = current_stats();
+    
+    {
+        std::pmr::vector<int> vector(memalloc::heap());
+        for (int i = 0; i < CPP_ELEMENTS; i++) {
+            vector.push_back(i);
+        }
+        cr_assert_eq(vector[CPP_ELEMENTS - 1], CPP_ELEMENTS - 1, "Elements should survive growth");
+        cr_assert_geq(mem_get_block_size(vector.data()), CPP_ELEMENTS * sizeof(int),
+                      "Storage should come from the heaps");
+        
+        void *aligned = memalloc::heap()->allocate(100, 512);
+        cr_assert(is_aligned(aligned, 512), "Heap resource should honour the alignment");
+        memalloc::heap()->deallocate(aligned, 100, 512);
+    }
+    
+    mem_stats_t after = current_stats();
+    cr_assert_eq(after.current_usage, before.current_usage, "Destruction should return all usage");
+    cr_assert(memalloc::heap()->is_equal(memalloc::heap_resource()), "Heap resources should compare equal");
+}
+
+Test(memory_resources, arena_resource_vector_growth)
+{
+    memalloc::arena_resource arena(4096);
+    
+    {
+        std::pmr::vector<std::pmr::string> strings(&arena);
+        for (int i = 0; i < 1000; i++) {
+            strings.emplace_back(static_cast<std::size_t>(i % 50) + 20, 'x');
+        }
+        cr_assert_eq(strings[999].size(), 69, "Arena strings should keep their contents");
+        
+        void *aligned = arena.allocate(10, 256);
+        cr_assert(is_aligned(aligned, 256), "Arena resource should honour the alignment");
+    }
+    
+    mem_arena_stats_t stats = { 0, 0, 0 };
+    mem_arena_get_stats(arena.arena(), &stats);
+    cr_assert_gt(stats.chunk_count, 1, "Growth should take more chunks");
+    
+    arena.release();
+    cr_assert(!arena.is_equal(memalloc::arena_resource()), "Distinct arenas should not compare equal");
+    cr_assert(mem_check_integrity(), "Heap should be valid after arena release");
+}
+
+Test(memory_resources, huge_requests_throw)
+{
+    memalloc::arena_resource arena(4096);
+    
+    cr_assert(allocation_throws(&arena, SIZE_MAX, 64), "Arena request whose slack wraps should throw");
+    cr_assert(allocation_throws(&arena, SIZE_MAX - 20, 256), "Arena request past the address space should throw");
+    cr_assert(allocation_throws(memalloc::heap(), SIZE_MAX, 64), "Heap request past the address space should throw");
+    cr_assert(allocation_throws(memalloc::heap(), SIZE_MAX - 7, 8), "Heap request whose alignment wraps should throw");
+    cr_assert(mem_check_integrity(), "Heap should be valid after refused requests");
+}